@@ -0,0 +1,244 @@
+// Checks AnimationKernels::ReduceKeys against a straightforward (quadratic) reduction,
+// and that every dropped key is reproduced within the tolerance, then compares their timings.
+// Also checks that QuaternionsToEuler stays continuous through gimbal lock.
+// Built by CMake with -DMSH2FBX_BENCHMARKS=ON, returns non zero on any mismatch.
+
+#include "stdafx.h"
+#include "AnimationKernels.h"
+#include <array>
+#include <chrono>
+#include <random>
+
+using namespace ConverterLib;
+
+// Whether all keys strictly between 'from' and 'to' lie on the line between those two
+static bool IsLinear(const vector<FbxTime>& times, const vector<float>& values, const size_t from, const size_t to, const float tolerance)
+{
+	const double t0 = (double)times[from].Get();
+	const double duration = (double)times[to].Get() - t0;
+	const double slope = duration > 0.0 ? (values[to] - (double)values[from]) / duration : 0.0;
+
+	for (size_t i = from + 1; i < to; ++i)
+	{
+		const double interpolated = values[from] + slope * ((double)times[i].Get() - t0);
+		if (std::abs(interpolated - values[i]) > tolerance)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// The greedy reduction, re-checking all keys of the segment for every candidate end
+static void ReduceKeysReference(const vector<FbxTime>& times, const vector<float>& values, const float tolerance, vector<FbxTime>& outTimes, vector<float>& outValues)
+{
+	outTimes.assign(1, times[0]);
+	outValues.assign(1, values[0]);
+
+	size_t anchor = 0;
+	for (size_t i = 1; i + 1 < times.size(); ++i)
+	{
+		if (!IsLinear(times, values, anchor, i + 1, tolerance))
+		{
+			anchor = i;
+			outTimes.push_back(times[i]);
+			outValues.push_back(values[i]);
+		}
+	}
+	outTimes.push_back(times.back());
+	outValues.push_back(values.back());
+}
+
+// Random walk with linear stretches and plateaus, one key per frame at 30 fps
+static void MakeCurve(std::mt19937& rng, const size_t count, vector<FbxTime>& times, vector<float>& values)
+{
+	std::uniform_real_distribution<float> step(-1.0f, 1.0f);
+	std::uniform_int_distribution<int> mode(0, 9);
+
+	times.resize(count);
+	values.resize(count);
+	float value = 0.0f, slope = 0.0f;
+	for (size_t i = 0; i < count; ++i)
+	{
+		const int roll = mode(rng);
+		if (roll == 0)
+		{
+			slope = step(rng);
+		}
+		else if (roll == 1)
+		{
+			slope = 0.0f;
+		}
+		value += slope + (roll < 5 ? step(rng) * 0.001f : 0.0f);
+
+		times[i] = FbxTime(FbxTime::GetOneSecond().Get() / 30 * (FbxLongLong)i);
+		values[i] = value;
+	}
+}
+
+static bool CheckReduction(const char* name, const vector<FbxTime>& times, const vector<float>& values, const float tolerance)
+{
+	vector<FbxTime> reducedTimes, expectedTimes;
+	vector<float> reducedValues, expectedValues;
+	AnimationKernels::ReduceKeys(times, values, tolerance, reducedTimes, reducedValues);
+
+	// every dropped key is reproduced by interpolating the kept ones
+	size_t segment = 0;
+	for (size_t i = 0; i < times.size() && reducedTimes.size() > 1; ++i)
+	{
+		while (segment + 2 < reducedTimes.size() && reducedTimes[segment + 1].Get() <= times[i].Get())
+		{
+			++segment;
+		}
+
+		const double t0 = (double)reducedTimes[segment].Get();
+		const double alpha = ((double)times[i].Get() - t0) / ((double)reducedTimes[segment + 1].Get() - t0);
+		const double interpolated = reducedValues[segment] + alpha * ((double)reducedValues[segment + 1] - reducedValues[segment]);
+		if (std::abs(interpolated - values[i]) > tolerance * 1.001)
+		{
+			std::cout << "MISMATCH in '" << name << "': key " << i << " is off by " << std::abs(interpolated - values[i]) << std::endl;
+			return false;
+		}
+	}
+
+	// a constant channel collapses to one key, which the reference doesn't do
+	if (reducedTimes.size() == 1)
+	{
+		return true;
+	}
+
+	ReduceKeysReference(times, values, tolerance, expectedTimes, expectedValues);
+	if (reducedTimes != expectedTimes)
+	{
+		std::cout << "MISMATCH in '" << name << "': kept " << reducedTimes.size() << " keys, expected " << expectedTimes.size() << std::endl;
+		return false;
+	}
+	return true;
+}
+
+// Quaternion of the XYZ Euler rotation (R = Rz * Ry * Rx), angles in degrees
+static Vector4 EulerToQuaternion(const double x, const double y, const double z)
+{
+	const double halfToRad = 3.14159265358979323846 / 360.0;
+	const double cx = std::cos(x * halfToRad), sx = std::sin(x * halfToRad);
+	const double cy = std::cos(y * halfToRad), sy = std::sin(y * halfToRad);
+	const double cz = std::cos(z * halfToRad), sz = std::sin(z * halfToRad);
+
+	Vector4 q;
+	q.m_X = (float)(sx * cy * cz - cx * sy * sz);
+	q.m_Y = (float)(cx * sy * cz + sx * cy * sz);
+	q.m_Z = (float)(cx * cy * sz - sx * sy * cz);
+	q.m_W = (float)(cx * cy * cz + sx * sy * sz);
+	return q;
+}
+
+// Converts the given rotations and compares the result against the angles they were built from
+static bool CheckEuler(const char* name, const vector<std::array<double, 3>>& angles)
+{
+	vector<Vector4> quaternions;
+	for (const std::array<double, 3>& a : angles)
+	{
+		quaternions.push_back(EulerToQuaternion(a[0], a[1], a[2]));
+	}
+
+	vector<float> x(angles.size()), y(angles.size()), z(angles.size());
+	AnimationKernels::AlignQuaternions(quaternions.data(), quaternions.data(), quaternions.size());
+	AnimationKernels::QuaternionsToEuler(quaternions.data(), quaternions.size(), x.data(), y.data(), z.data());
+
+	for (size_t i = 0; i < angles.size(); ++i)
+	{
+		const double error = std::max({ std::abs(x[i] - angles[i][0]), std::abs(y[i] - angles[i][1]), std::abs(z[i] - angles[i][2]) });
+		if (error > 0.05)
+		{
+			std::cout << "MISMATCH in '" << name << "': key " << i << " is (" << x[i] << ", " << y[i] << ", " << z[i] << "), expected ("
+				<< angles[i][0] << ", " << angles[i][1] << ", " << angles[i][2] << ")" << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+int main()
+{
+	bool bPassed = true;
+	vector<FbxTime> times;
+	vector<float> values;
+
+	// hand written cases
+	auto makeKeys = [&](const vector<float>& keys)
+	{
+		times.clear();
+		values = keys;
+		for (size_t i = 0; i < keys.size(); ++i)
+		{
+			times.push_back(FbxTime((FbxLongLong)i * 1000));
+		}
+	};
+
+	makeKeys({ 0, 1, 2, 3, 4 });
+	bPassed &= CheckReduction("line", times, values, 0.001f);
+	makeKeys({ 0, 1, 2, 1, 0 });
+	bPassed &= CheckReduction("peak", times, values, 0.001f);
+	makeKeys({ 5, 5, 5, 5 });
+	bPassed &= CheckReduction("constant", times, values, 0.001f);
+	makeKeys({ 0, 0.0005f, 0, 0.0005f, 0, 1 });
+	bPassed &= CheckReduction("noise", times, values, 0.001f);
+
+	std::mt19937 rng(1138);
+	for (int i = 0; i < 1000; ++i)
+	{
+		MakeCurve(rng, 200, times, values);
+		bPassed &= CheckReduction("random", times, values, 0.01f);
+	}
+
+	// pitch crossing +90 and -90, the decomposition itself flips to (x + 180, 180 - y, z + 180) there
+	vector<std::array<double, 3>> angles;
+	for (double pitch = 71.0; pitch < 110.0; pitch += 2.0)
+	{
+		angles.push_back({ 30.0, pitch, -40.0 });
+	}
+	bPassed &= CheckEuler("gimbal lock", angles);
+
+	angles.clear();
+	for (double pitch = -71.0; pitch > -110.0; pitch -= 2.0)
+	{
+		angles.push_back({ -120.0, pitch, 75.0 });
+	}
+	bPassed &= CheckEuler("gimbal lock (negative)", angles);
+
+	// full turns around each axis
+	angles.clear();
+	for (double angle = 0.0; angle < 720.0; angle += 25.0)
+	{
+		angles.push_back({ angle, 10.0, -angle * 0.5 });
+	}
+	bPassed &= CheckEuler("spin", angles);
+
+	// timing, on a long and dense clip with long linear stretches
+	MakeCurve(rng, 20000, times, values);
+	for (size_t i = 5000; i < 15000; ++i)
+	{
+		values[i] = values[5000] + (float)(i - 5000) * 0.01f;
+	}
+
+	using Clock = std::chrono::steady_clock;
+	vector<FbxTime> outTimes;
+	vector<float> outValues;
+
+	const Clock::time_point referenceStart = Clock::now();
+	ReduceKeysReference(times, values, 0.003f, outTimes, outValues);
+	const double referenceMs = std::chrono::duration<double, std::milli>(Clock::now() - referenceStart).count();
+	const size_t referenceKeys = outTimes.size();
+
+	const Clock::time_point reduceStart = Clock::now();
+	AnimationKernels::ReduceKeys(times, values, 0.003f, outTimes, outValues);
+	const double reduceMs = std::chrono::duration<double, std::milli>(Clock::now() - reduceStart).count();
+
+	// both keep the same keys, up to rounding right at the tolerance
+	std::cout << times.size() << " keys, " << outTimes.size() << " kept (reference: " << referenceKeys << ")" << std::endl;
+	std::cout << "Reference:  " << referenceMs << " ms" << std::endl;
+	std::cout << "ReduceKeys: " << reduceMs << " ms" << std::endl;
+
+	std::cout << (bPassed ? "All checks passed" : "CHECKS FAILED") << std::endl;
+	return bPassed ? 0 : 1;
+}
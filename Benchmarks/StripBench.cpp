@@ -0,0 +1,192 @@
+// Checks GeometryKernels::DecodeTriangleStrips against LibSWBF2's STRP::CalcPolygons
+// (triangle for triangle, including winding) and compares their timings.
+// Built by CMake with -DMSH2FBX_BENCHMARKS=ON, returns non zero on any mismatch.
+
+#include "stdafx.h"
+#include "GeometryKernels.h"
+#include <chrono>
+#include <random>
+
+using namespace ConverterLib;
+using namespace LibSWBF2::Chunks::MSH;
+
+static const uint16_t StripStart = 0x8000;
+
+// Random strips in MSH encoding, every strip starting with two flagged indices.
+// Mixes in repeated indices (degenerated triangles) and out of range indices
+static vector<uint16_t> MakeStrips(std::mt19937& rng, const uint16_t numVertices, const size_t numStrips)
+{
+	std::uniform_int_distribution<int> length(3, 24);
+	std::uniform_int_distribution<int> index(0, numVertices - 1);
+	std::uniform_int_distribution<int> special(0, 99);
+
+	vector<uint16_t> strips;
+	for (size_t s = 0; s < numStrips; ++s)
+	{
+		const int n = length(rng);
+		for (int i = 0; i < n; ++i)
+		{
+			uint16_t value = (uint16_t)index(rng);
+			const int roll = special(rng);
+			if (roll < 5 && i > 0)
+			{
+				value = strips.back() & ~StripStart;
+			}
+			else if (roll < 7)
+			{
+				value = numVertices + (uint16_t)roll;
+			}
+			strips.push_back(i < 2 ? value | StripStart : value);
+		}
+	}
+	return strips;
+}
+
+// What the converter used to emit: all CalcPolygons triangles, minus
+// the ones DecodeTriangleStrips is documented to drop
+static vector<int32_t> ReferenceTriangles(SEGM& segment, const size_t numVertices)
+{
+	segment.m_TriangleList.m_Polygons.Clear();
+	segment.m_TriangleList.CalcPolygons();
+
+	vector<int32_t> triangles;
+	for (size_t i = 0; i < segment.m_TriangleList.m_Polygons.Size(); ++i)
+	{
+		auto& poly = segment.m_TriangleList.m_Polygons[i];
+		if (poly.m_VertexIndices.Size() != 3)
+		{
+			continue;
+		}
+
+		const uint16_t a = poly.m_VertexIndices[0], b = poly.m_VertexIndices[1], c = poly.m_VertexIndices[2];
+		if (a == b || b == c || a == c || a >= numVertices || b >= numVertices || c >= numVertices)
+		{
+			continue;
+		}
+		triangles.push_back(a);
+		triangles.push_back(b);
+		triangles.push_back(c);
+	}
+	return triangles;
+}
+
+static bool Check(const char* name, const vector<uint16_t>& strips, const uint16_t numVertices)
+{
+	SEGM segment;
+	for (const uint16_t index : strips)
+	{
+		segment.m_TriangleList.m_Triangles.Add(index);
+	}
+
+	const vector<int32_t> expected = ReferenceTriangles(segment, numVertices);
+	vector<int32_t> decoded;
+	if (!strips.empty())
+	{
+		GeometryKernels::DecodeTriangleStrips(strips.data(), strips.size(), nullptr, numVertices, 0, decoded);
+	}
+
+	if (decoded == expected)
+	{
+		return true;
+	}
+
+	std::cout << "MISMATCH in '" << name << "': expected " << expected.size() / 3 << " triangles, decoded " << decoded.size() / 3 << std::endl;
+	for (size_t i = 0; i < std::min(expected.size(), decoded.size()); i += 3)
+	{
+		if (expected[i] != decoded[i] || expected[i + 1] != decoded[i + 1] || expected[i + 2] != decoded[i + 2])
+		{
+			std::cout << "\tfirst difference at triangle " << i / 3 << ": expected (" << expected[i] << ", " << expected[i + 1] << ", " << expected[i + 2]
+				<< "), decoded (" << decoded[i] << ", " << decoded[i + 1] << ", " << decoded[i + 2] << ")" << std::endl;
+			break;
+		}
+	}
+	return false;
+}
+
+static Vector3 MakeVector(const float x, const float y, const float z)
+{
+	Vector3 vector;
+	vector.m_X = x;
+	vector.m_Y = y;
+	vector.m_Z = z;
+	return vector;
+}
+
+// Collinearity needs positions, which CalcPolygons knows nothing about.
+// Checks the number of triangles kept for a single one
+static bool CheckPositions(const char* name, const vector<Vector3>& positions, const size_t expected)
+{
+	const uint16_t strips[] = { 0 | StripStart, 1 | StripStart, 2 };
+	vector<int32_t> decoded;
+	const size_t numTriangles = GeometryKernels::DecodeTriangleStrips(strips, 3, positions.data(), positions.size(), 0, decoded);
+	if (numTriangles == expected)
+	{
+		return true;
+	}
+
+	std::cout << "MISMATCH in '" << name << "': expected " << expected << " triangles, decoded " << numTriangles << std::endl;
+	return false;
+}
+
+int main()
+{
+	const uint16_t S = StripStart;
+	bool bPassed = true;
+
+	// hand written cases: winding flips, restarts, degenerates, out of range
+	bPassed &= Check("single triangle", { 0 | S, 1 | S, 2 }, 8);
+	bPassed &= Check("winding", { 0 | S, 1 | S, 2, 3, 4, 5 }, 8);
+	bPassed &= Check("restart", { 0 | S, 1 | S, 2, 3, 4 | S, 5 | S, 6, 7 }, 8);
+	bPassed &= Check("degenerated", { 0 | S, 1 | S, 2, 2, 3, 4 }, 8);
+	bPassed &= Check("out of range", { 0 | S, 1 | S, 2, 9, 3 }, 8);
+
+	// degenerated by shape, not by scale
+	bPassed &= CheckPositions("collinear", { MakeVector(0, 0, 0), MakeVector(1, 0, 0), MakeVector(2, 0, 0) }, 0);
+	bPassed &= CheckPositions("large sliver", { MakeVector(0, 0, 0), MakeVector(1000, 0, 0), MakeVector(2000, 0.0001f, 0) }, 0);
+	bPassed &= CheckPositions("tiny", { MakeVector(0, 0, 0), MakeVector(1e-5f, 0, 0), MakeVector(0, 1e-5f, 0) }, 1);
+	bPassed &= CheckPositions("tiny thin", { MakeVector(0, 0, 0), MakeVector(1e-5f, 0, 0), MakeVector(1e-5f, 1e-7f, 0) }, 1);
+	bPassed &= CheckPositions("large", { MakeVector(-5000, 0, 0), MakeVector(5000, 0, 0), MakeVector(0, 0, 3000) }, 1);
+
+	std::mt19937 rng(1138);
+	for (int i = 0; i < 1000; ++i)
+	{
+		bPassed &= Check("random", MakeStrips(rng, 512, 64), 512);
+	}
+
+	// timing, on a segment of typical size
+	const uint16_t numVertices = 20000;
+	const vector<uint16_t> strips = MakeStrips(rng, numVertices, 4000);
+	SEGM segment;
+	for (const uint16_t index : strips)
+	{
+		segment.m_TriangleList.m_Triangles.Add(index);
+	}
+
+	const int runs = 200;
+	using Clock = std::chrono::steady_clock;
+
+	size_t referenceCount = 0;
+	const Clock::time_point referenceStart = Clock::now();
+	for (int r = 0; r < runs; ++r)
+	{
+		referenceCount += ReferenceTriangles(segment, numVertices).size();
+	}
+	const double referenceMs = std::chrono::duration<double, std::milli>(Clock::now() - referenceStart).count() / runs;
+
+	size_t decodedCount = 0;
+	vector<int32_t> triangles;
+	const Clock::time_point decodeStart = Clock::now();
+	for (int r = 0; r < runs; ++r)
+	{
+		triangles.clear();
+		decodedCount += GeometryKernels::DecodeTriangleStrips(strips.data(), strips.size(), nullptr, numVertices, 0, triangles) * 3;
+	}
+	const double decodeMs = std::chrono::duration<double, std::milli>(Clock::now() - decodeStart).count() / runs;
+
+	std::cout << strips.size() << " strip indices, " << triangles.size() / 3 << " triangles" << std::endl;
+	std::cout << "CalcPolygons:         " << referenceMs << " ms" << std::endl;
+	std::cout << "DecodeTriangleStrips: " << decodeMs << " ms" << std::endl;
+	std::cout << (bPassed && referenceCount == decodedCount ? "All checks passed" : "CHECKS FAILED") << std::endl;
+
+	return bPassed && referenceCount == decodedCount ? 0 : 1;
+}
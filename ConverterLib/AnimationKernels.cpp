@@ -0,0 +1,409 @@
+#include "stdafx.h"
+#include "AnimationKernels.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MSH2FBX_SSE2
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace ConverterLib
+{
+	namespace AnimationKernels
+	{
+		static_assert(sizeof(Vector4) == 4 * sizeof(float), "Vector4 is expected to be four packed floats!");
+
+		static const double RadToDeg = 180.0 / 3.14159265358979323846;
+
+		void AlignQuaternions(const Vector4* src, Vector4* dst, size_t count)
+		{
+			float prev[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				const Vector4& q = src[i];
+				float x = q.m_X, y = q.m_Y, z = q.m_Z, w = q.m_W;
+
+				const float lengthSq = x * x + y * y + z * z + w * w;
+				if (lengthSq > 0.0f)
+				{
+					const float invLength = 1.0f / std::sqrt(lengthSq);
+					x *= invLength; y *= invLength; z *= invLength; w *= invLength;
+				}
+				else
+				{
+					x = 0.0f; y = 0.0f; z = 0.0f; w = 1.0f;
+				}
+
+				if (i > 0 && x * prev[0] + y * prev[1] + z * prev[2] + w * prev[3] < 0.0f)
+				{
+					x = -x; y = -y; z = -z; w = -w;
+				}
+
+				dst[i].m_X = prev[0] = x;
+				dst[i].m_Y = prev[1] = y;
+				dst[i].m_Z = prev[2] = z;
+				dst[i].m_W = prev[3] = w;
+			}
+		}
+
+		// Euler XYZ (R = Rz * Ry * Rx) from the 5 matrix terms the angles depend on
+		static void TermsToEuler(const float sinX, const float cosX, const float sinY, const float sinZ, const float cosZ, float& outX, float& outY, float& outZ)
+		{
+			outX = (float)(std::atan2((double)sinX, (double)cosX) * RadToDeg);
+			outY = (float)(std::asin(clamp((double)sinY, -1.0, 1.0)) * RadToDeg);
+			outZ = (float)(std::atan2((double)sinZ, (double)cosZ) * RadToDeg);
+		}
+
+		// Moves 'angle' by whole turns into the 360 degree window around 'reference'
+		static float WrapTo(const float angle, const float reference)
+		{
+			return angle - 360.0f * std::round((angle - reference) / 360.0f);
+		}
+
+		// Every rotation has a second XYZ triple, (x + 180, 180 - y, z + 180). Near gimbal lock
+		// (|y| close to 90) the decomposition jumps between the two, which unwrapping each axis
+		// on its own can't undo, so every key takes whichever triple is closest to its predecessor
+		static void Unwrap(float* outX, float* outY, float* outZ, size_t count)
+		{
+			for (size_t i = 1; i < count; ++i)
+			{
+				const float prevX = outX[i - 1], prevY = outY[i - 1], prevZ = outZ[i - 1];
+
+				const float x = WrapTo(outX[i], prevX);
+				const float y = WrapTo(outY[i], prevY);
+				const float z = WrapTo(outZ[i], prevZ);
+
+				const float altX = WrapTo(outX[i] + 180.0f, prevX);
+				const float altY = WrapTo(180.0f - outY[i], prevY);
+				const float altZ = WrapTo(outZ[i] + 180.0f, prevZ);
+
+				const float distance = std::abs(x - prevX) + std::abs(y - prevY) + std::abs(z - prevZ);
+				const float altDistance = std::abs(altX - prevX) + std::abs(altY - prevY) + std::abs(altZ - prevZ);
+				if (altDistance < distance)
+				{
+					outX[i] = altX; outY[i] = altY; outZ[i] = altZ;
+				}
+				else
+				{
+					outX[i] = x; outY[i] = y; outZ[i] = z;
+				}
+			}
+		}
+
+		void QuaternionsToEuler(const Vector4* quaternions, size_t count, float* outX, float* outY, float* outZ)
+		{
+			size_t i = 0;
+
+#if defined(MSH2FBX_SSE2)
+			// four quaternions at a time, transposed into one register per component
+			const __m128 one = _mm_set1_ps(1.0f);
+			const __m128 two = _mm_set1_ps(2.0f);
+			alignas(16) float sinX[4], cosX[4], sinY[4], sinZ[4], cosZ[4];
+
+			for (; i + 4 <= count; i += 4)
+			{
+				__m128 x = _mm_loadu_ps(&quaternions[i].m_X);
+				__m128 y = _mm_loadu_ps(&quaternions[i + 1].m_X);
+				__m128 z = _mm_loadu_ps(&quaternions[i + 2].m_X);
+				__m128 w = _mm_loadu_ps(&quaternions[i + 3].m_X);
+				_MM_TRANSPOSE4_PS(x, y, z, w);
+
+				const __m128 xx = _mm_mul_ps(x, x);
+				const __m128 yy = _mm_mul_ps(y, y);
+				const __m128 zz = _mm_mul_ps(z, z);
+
+				// sinX = 2(wx + yz), cosX = 1 - 2(xx + yy)
+				_mm_store_ps(sinX, _mm_mul_ps(two, _mm_add_ps(_mm_mul_ps(w, x), _mm_mul_ps(y, z))));
+				_mm_store_ps(cosX, _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))));
+
+				// sinY = 2(wy - zx)
+				_mm_store_ps(sinY, _mm_mul_ps(two, _mm_sub_ps(_mm_mul_ps(w, y), _mm_mul_ps(z, x))));
+
+				// sinZ = 2(wz + xy), cosZ = 1 - 2(yy + zz)
+				_mm_store_ps(sinZ, _mm_mul_ps(two, _mm_add_ps(_mm_mul_ps(w, z), _mm_mul_ps(x, y))));
+				_mm_store_ps(cosZ, _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))));
+
+				for (size_t j = 0; j < 4; ++j)
+				{
+					TermsToEuler(sinX[j], cosX[j], sinY[j], sinZ[j], cosZ[j], outX[i + j], outY[i + j], outZ[i + j]);
+				}
+			}
+#endif
+
+			for (; i < count; ++i)
+			{
+				const float x = quaternions[i].m_X, y = quaternions[i].m_Y, z = quaternions[i].m_Z, w = quaternions[i].m_W;
+				TermsToEuler(
+					2.0f * (w * x + y * z), 1.0f - 2.0f * (x * x + y * y),
+					2.0f * (w * y - z * x),
+					2.0f * (w * z + x * y), 1.0f - 2.0f * (y * y + z * z),
+					outX[i], outY[i], outZ[i]
+				);
+			}
+
+			Unwrap(outX, outY, outZ, count);
+		}
+
+		void ReduceKeys(const vector<FbxTime>& times, const vector<float>& values, const float tolerance, vector<FbxTime>& outTimes, vector<float>& outValues)
+		{
+			outTimes.clear();
+			outValues.clear();
+
+			const size_t count = times.size();
+			if (count == 0)
+			{
+				return;
+			}
+
+			// constant channel
+			const auto [minIt, maxIt] = std::minmax_element(values.begin(), values.end());
+			if (*maxIt - values[0] <= tolerance && values[0] - *minIt <= tolerance)
+			{
+				outTimes.push_back(times[0]);
+				outValues.push_back(values[0]);
+				return;
+			}
+
+			outTimes.reserve(count);
+			outValues.reserve(count);
+
+			// Greedy: starting at the last kept key, extend the segment for as long as all
+			// keys in between are reproduced by interpolation. Every key in between narrows
+			// the range of slopes a line from the anchor may have to pass within 'tolerance'
+			// of it, so each key is only looked at once instead of for every candidate end
+			const double inf = std::numeric_limits<double>::infinity();
+			size_t anchor = 0;
+			double minSlope = -inf;
+			double maxSlope = inf;
+			outTimes.push_back(times[0]);
+			outValues.push_back(values[0]);
+
+			for (size_t i = 1; i + 1 < count; ++i)
+			{
+				const double t0 = (double)times[anchor].Get();
+				const double v0 = values[anchor];
+
+				// key i lies between the anchor and the candidate end i + 1
+				const double dt = (double)times[i].Get() - t0;
+				if (dt > 0.0)
+				{
+					minSlope = std::max(minSlope, (values[i] - tolerance - v0) / dt);
+					maxSlope = std::min(maxSlope, (values[i] + tolerance - v0) / dt);
+				}
+				else if (std::abs(values[i] - v0) > tolerance)
+				{
+					minSlope = inf;
+				}
+
+				const double duration = (double)times[i + 1].Get() - t0;
+				const double slope = duration > 0.0 ? (values[i + 1] - v0) / duration : 0.0;
+				if (slope < minSlope || slope > maxSlope)
+				{
+					anchor = i;
+					minSlope = -inf;
+					maxSlope = inf;
+					outTimes.push_back(times[i]);
+					outValues.push_back(values[i]);
+				}
+			}
+
+			outTimes.push_back(times[count - 1]);
+			outValues.push_back(values[count - 1]);
+		}
+	
+		size_t HashKeys(const vector<FbxTime>& times, const vector<float>& values)
+		{
+			uint64_t hash = 14695981039346656037ull;
+			auto hashBytes = [&hash](const void* data, const size_t size)
+			{
+				const uint8_t* bytes = (const uint8_t*)data;
+				for (size_t i = 0; i < size; ++i)
+				{
+					hash ^= bytes[i];
+					hash *= 1099511628211ull;
+				}
+			};
+
+			for (size_t i = 0; i < times.size(); ++i)
+			{
+				const FbxLongLong ticks = times[i].Get();
+				hashBytes(&ticks, sizeof(ticks));
+			}
+			hashBytes(values.data(), values.size() * sizeof(float));
+			return (size_t)hash;
+		}
+
+		void ComputeSamplePositions(const uint32_t* frames, const size_t numKeys, const double start, const double step, const size_t count, uint32_t* outKeys, float* outWeights)
+		{
+			// samples are ascending, so the key segment is found by walking forward
+			size_t key = 0;
+			for (size_t i = 0; i < count; ++i)
+			{
+				const double position = clamp(start + i * step, (double)frames[0], (double)frames[numKeys - 1]);
+				while (key + 2 < numKeys && frames[key + 1] <= position)
+				{
+					++key;
+				}
+
+				const double length = (double)frames[key + 1] - frames[key];
+				outKeys[i] = (uint32_t)key;
+				outWeights[i] = length > 0.0 ? (float)clamp((position - frames[key]) / length, 0.0, 1.0) : 0.0f;
+			}
+		}
+
+		void LerpKeys(const float* values, const uint32_t* keys, const float* weights, const size_t count, float* out)
+		{
+			size_t i = 0;
+
+#if defined(__AVX2__)
+			for (; i + 8 <= count; i += 8)
+			{
+				const __m256i key = _mm256_loadu_si256((const __m256i*)&keys[i]);
+				const __m256 from = _mm256_i32gather_ps(values, key, 4);
+				const __m256 to = _mm256_i32gather_ps(values + 1, key, 4);
+				const __m256 weight = _mm256_loadu_ps(&weights[i]);
+				_mm256_storeu_ps(&out[i], _mm256_add_ps(from, _mm256_mul_ps(_mm256_sub_ps(to, from), weight)));
+			}
+#endif
+
+			for (; i < count; ++i)
+			{
+				const float from = values[keys[i]];
+				const float to = values[keys[i] + 1];
+				out[i] = from + (to - from) * weights[i];
+			}
+		}
+
+		// Slerp without any trigonometry, see "A Fast and Accurate Algorithm for
+		// Computing SLERP" (D. Eberly). sin(t * theta) / sin(theta) is expanded into
+		// a polynomial of t and cos(theta), which vectorizes. It is accurate to float
+		// precision for cos(theta) >= 0.5, keys further apart are slerped exactly.
+		static const float SlerpMu = 1.85298109240830f;
+		static const float SlerpU[8] = { 1.0f / (1 * 3), 1.0f / (2 * 5), 1.0f / (3 * 7), 1.0f / (4 * 9), 1.0f / (5 * 11), 1.0f / (6 * 13), 1.0f / (7 * 15), SlerpMu / (8 * 17) };
+		static const float SlerpV[8] = { 1.0f / 3, 2.0f / 5, 3.0f / 7, 4.0f / 9, 5.0f / 11, 6.0f / 13, 7.0f / 15, SlerpMu * 8 / 17 };
+		static const float SlerpMinCosTheta = 0.5f;
+
+		static void SlerpExact(const Vector4& q0, const Vector4& q1, const float t, Vector4& out)
+		{
+			const double cosTheta = clamp((double)q0.m_X * q1.m_X + (double)q0.m_Y * q1.m_Y + (double)q0.m_Z * q1.m_Z + (double)q0.m_W * q1.m_W, -1.0, 1.0);
+			const double theta = std::acos(cosTheta);
+			const double sinTheta = std::sin(theta);
+
+			double c0 = 1.0 - t;
+			double c1 = t;
+			if (sinTheta > 1e-6)
+			{
+				c0 = std::sin((1.0 - t) * theta) / sinTheta;
+				c1 = std::sin(t * theta) / sinTheta;
+			}
+
+			out.m_X = (float)(q0.m_X * c0 + q1.m_X * c1);
+			out.m_Y = (float)(q0.m_Y * c0 + q1.m_Y * c1);
+			out.m_Z = (float)(q0.m_Z * c0 + q1.m_Z * c1);
+			out.m_W = (float)(q0.m_W * c0 + q1.m_W * c1);
+		}
+
+		void SlerpKeys(const Vector4* quaternions, const uint32_t* keys, const float* weights, const size_t count, Vector4* out)
+		{
+			size_t i = 0;
+
+#if defined(MSH2FBX_SSE2)
+			// four samples at a time, transposed into one register per component
+			const __m128 one = _mm_set1_ps(1.0f);
+			for (; i + 4 <= count; i += 4)
+			{
+				__m128 x0 = _mm_loadu_ps(&quaternions[keys[i]].m_X);
+				__m128 y0 = _mm_loadu_ps(&quaternions[keys[i + 1]].m_X);
+				__m128 z0 = _mm_loadu_ps(&quaternions[keys[i + 2]].m_X);
+				__m128 w0 = _mm_loadu_ps(&quaternions[keys[i + 3]].m_X);
+				_MM_TRANSPOSE4_PS(x0, y0, z0, w0);
+
+				__m128 x1 = _mm_loadu_ps(&quaternions[keys[i] + 1].m_X);
+				__m128 y1 = _mm_loadu_ps(&quaternions[keys[i + 1] + 1].m_X);
+				__m128 z1 = _mm_loadu_ps(&quaternions[keys[i + 2] + 1].m_X);
+				__m128 w1 = _mm_loadu_ps(&quaternions[keys[i + 3] + 1].m_X);
+				_MM_TRANSPOSE4_PS(x1, y1, z1, w1);
+
+				const __m128 cosTheta = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x0, x1), _mm_mul_ps(y0, y1)), _mm_add_ps(_mm_mul_ps(z0, z1), _mm_mul_ps(w0, w1)));
+				const __m128 xm1 = _mm_sub_ps(cosTheta, one);
+				const __m128 t = _mm_loadu_ps(&weights[i]);
+				const __m128 d = _mm_sub_ps(one, t);
+				const __m128 sqrT = _mm_mul_ps(t, t);
+				const __m128 sqrD = _mm_mul_ps(d, d);
+
+				// Horner scheme, from the highest order term down
+				__m128 cT = one;
+				__m128 cD = one;
+				for (int j = 7; j >= 0; --j)
+				{
+					const __m128 u = _mm_set1_ps(SlerpU[j]);
+					const __m128 v = _mm_set1_ps(SlerpV[j]);
+					const __m128 bT = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(u, sqrT), v), xm1);
+					const __m128 bD = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(u, sqrD), v), xm1);
+					cT = _mm_add_ps(one, _mm_mul_ps(bT, cT));
+					cD = _mm_add_ps(one, _mm_mul_ps(bD, cD));
+				}
+				cT = _mm_mul_ps(cT, t);
+				cD = _mm_mul_ps(cD, d);
+
+				__m128 x = _mm_add_ps(_mm_mul_ps(x0, cD), _mm_mul_ps(x1, cT));
+				__m128 y = _mm_add_ps(_mm_mul_ps(y0, cD), _mm_mul_ps(y1, cT));
+				__m128 z = _mm_add_ps(_mm_mul_ps(z0, cD), _mm_mul_ps(z1, cT));
+				__m128 w = _mm_add_ps(_mm_mul_ps(w0, cD), _mm_mul_ps(w1, cT));
+				_MM_TRANSPOSE4_PS(x, y, z, w);
+
+				_mm_storeu_ps(&out[i].m_X, x);
+				_mm_storeu_ps(&out[i + 1].m_X, y);
+				_mm_storeu_ps(&out[i + 2].m_X, z);
+				_mm_storeu_ps(&out[i + 3].m_X, w);
+
+				// rare, keys more than 120 degrees apart
+				const int farApart = _mm_movemask_ps(_mm_cmplt_ps(cosTheta, _mm_set1_ps(SlerpMinCosTheta)));
+				for (size_t j = 0; farApart != 0 && j < 4; ++j)
+				{
+					if (farApart & (1 << j))
+					{
+						SlerpExact(quaternions[keys[i + j]], quaternions[keys[i + j] + 1], weights[i + j], out[i + j]);
+					}
+				}
+			}
+#endif
+
+			for (; i < count; ++i)
+			{
+				const Vector4& q0 = quaternions[keys[i]];
+				const Vector4& q1 = quaternions[keys[i] + 1];
+
+				const float cosTheta = q0.m_X * q1.m_X + q0.m_Y * q1.m_Y + q0.m_Z * q1.m_Z + q0.m_W * q1.m_W;
+				const float t = weights[i];
+				if (cosTheta < SlerpMinCosTheta)
+				{
+					SlerpExact(q0, q1, t, out[i]);
+					continue;
+				}
+
+				const float xm1 = cosTheta - 1.0f;
+				const float d = 1.0f - t;
+
+				float cT = 1.0f;
+				float cD = 1.0f;
+				for (int j = 7; j >= 0; --j)
+				{
+					cT = 1.0f + (SlerpU[j] * t * t - SlerpV[j]) * xm1 * cT;
+					cD = 1.0f + (SlerpU[j] * d * d - SlerpV[j]) * xm1 * cD;
+				}
+				cT *= t;
+				cD *= d;
+
+				out[i].m_X = q0.m_X * cD + q1.m_X * cT;
+				out[i].m_Y = q0.m_Y * cD + q1.m_Y * cT;
+				out[i].m_Z = q0.m_Z * cD + q1.m_Z * cT;
+				out[i].m_W = q0.m_W * cD + q1.m_W * cT;
+			}
+		}
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+namespace ConverterLib
+{
+	using LibSWBF2::Types::Vector4;
+
+	namespace AnimationKernels
+	{
+		// Normalizes 'count' quaternions and flips each one into the hemisphere
+		// of its predecessor (q and -q are the same rotation), so interpolating
+		// between consecutive keys always takes the short way.
+		// 'src' and 'dst' may be the same array.
+		void AlignQuaternions(const Vector4* src, Vector4* dst, size_t count);
+
+		// Converts 'count' unit quaternions to Euler angles in degrees, in FBX's
+		// default XYZ rotation order, writing each axis into its own array.
+		// Each key is the equivalent triple closest to the previous one and the
+		// angles are unwrapped, so consecutive keys never differ by more than 180
+		// degrees per axis, also where the rotation passes through gimbal lock.
+		void QuaternionsToEuler(const Vector4* quaternions, size_t count, float* outX, float* outY, float* outZ);
+
+		// Keyframe reduction of a single channel. Keys which linear interpolation
+		// between the remaining keys already reproduces within 'tolerance' are dropped.
+		// A channel that stays within 'tolerance' of its first value collapses to one key.
+		// 'times' and 'values' must be of the same length and sorted by time.
+		void ReduceKeys(const vector<FbxTime>& times, const vector<float>& values, const float tolerance, vector<FbxTime>& outTimes, vector<float>& outValues);
+	
+		// Hash over key times and values (FNV-1a), to find identical curves
+		size_t HashKeys(const vector<FbxTime>& times, const vector<float>& values);
+
+		// Resampling. Sample 'i' lies at frame 'start + i * step' (clamped to the keys),
+		// each sample is described by the key it follows and its weight towards the next key.
+		// 'frames' must be ascending and hold at least two keys.
+		void ComputeSamplePositions(const uint32_t* frames, const size_t numKeys, const double start, const double step, const size_t count, uint32_t* outKeys, float* outWeights);
+
+		// Linear interpolation of one channel at the given sample positions
+		void LerpKeys(const float* values, const uint32_t* keys, const float* weights, const size_t count, float* out);
+
+		// Spherical linear interpolation at the given sample positions.
+		// The quaternions must be aligned (see AlignQuaternions)
+		void SlerpKeys(const Vector4* quaternions, const uint32_t* keys, const float* weights, const size_t count, Vector4* out);
+	}
+}
@@ -0,0 +1,84 @@
+#include "stdafx.h"
+#include "BaseposeCache.h"
+#include "MappedFile.h"
+#include "MSHScanner.h"
+
+namespace ConverterLib
+{
+	using namespace LibSWBF2::Chunks::MSH;
+
+	std::mutex BaseposeCache::EntriesMutex;
+	map<string, BaseposeCache::Entry> BaseposeCache::Entries;
+
+	std::shared_ptr<const ParsedBasepose> BaseposeCache::Get(const fs::path& mshFilePath)
+	{
+		std::error_code error;
+		const fs::file_time_type writeTime = fs::last_write_time(mshFilePath, error);
+		if (error)
+		{
+			return nullptr;
+		}
+
+		const string key = fs::absolute(mshFilePath, error).lexically_normal().u8string();
+
+		// Parsing happens under the lock, so the same file is never parsed twice at once
+		std::lock_guard<std::mutex> lock(EntriesMutex);
+
+		auto it = Entries.find(key);
+		if (it != Entries.end() && it->second.WriteTime == writeTime)
+		{
+			std::shared_ptr<const ParsedBasepose> pose = it->second.Pose.lock();
+			if (pose != nullptr)
+			{
+				return pose;
+			}
+		}
+
+		// drop entries no one holds anymore, while we're at it
+		for (auto entry = Entries.begin(); entry != Entries.end();)
+		{
+			entry = entry->second.Pose.expired() ? Entries.erase(entry) : std::next(entry);
+		}
+
+		std::shared_ptr<const ParsedBasepose> pose = Parse(mshFilePath);
+		Entries[key] = { writeTime, pose };
+		return pose;
+	}
+
+	std::shared_ptr<const ParsedBasepose> BaseposeCache::Parse(const fs::path& mshFilePath)
+	{
+		// Only the Animation chunks are of interest, so try to decode just those
+		ANM2 scanned;
+		MSH* msh = nullptr;
+		MSHScanner scanner;
+		if (!scanner.Open(mshFilePath) || !scanner.ReadAnimations(scanned))
+		{
+			msh = MSH::Create();
+			msh->ReadFromFile(mshFilePath.u8string().c_str());
+		}
+
+		std::shared_ptr<ParsedBasepose> pose = std::make_shared<ParsedBasepose>();
+
+		// A Basepose file contains an Animation with only one Frame
+		// defining the Basepose. So ignore all possible other frames
+		List<BoneFrames>& boneFrames = msh != nullptr ? msh->m_Animations.m_KeyFrames.m_BoneFrames : scanned.m_KeyFrames.m_BoneFrames;
+		pose->Bones.resize(boneFrames.Size());
+		for (size_t i = 0; i < boneFrames.Size(); ++i)
+		{
+			BoneFrames& frames = boneFrames[i];
+			ParsedBasepose::Bone& bone = pose->Bones[i];
+
+			bone.CRC = frames.m_CRCchecksum;
+			bone.bHasTranslation = frames.m_TranslationFrames.Size() > 0;
+			bone.bHasRotation = frames.m_RotationFrames.Size() > 0;
+			bone.Translation = bone.bHasTranslation ? frames.m_TranslationFrames[0].m_Translation : Vector3();
+			bone.Rotation = bone.bHasRotation ? frames.m_RotationFrames[0].m_Rotation : Vector4();
+		}
+
+		if (msh != nullptr)
+		{
+			MSH::Destroy(msh);
+		}
+		return pose;
+	}
+}
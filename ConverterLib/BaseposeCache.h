@@ -0,0 +1,48 @@
+#pragma once
+
+namespace ConverterLib
+{
+	using LibSWBF2::CRCChecksum;
+	using LibSWBF2::Types::Vector3;
+	using LibSWBF2::Types::Vector4;
+	namespace fs = std::filesystem;
+
+	// The Basepose of a Skeleton, as stored in the first frame of
+	// a Basepose MSHs Animation. Never changes once loaded
+	struct ParsedBasepose
+	{
+		struct Bone
+		{
+			CRCChecksum CRC;
+			Vector3 Translation;
+			Vector4 Rotation;
+			bool bHasTranslation;
+			bool bHasRotation;
+		};
+
+		// in file order
+		vector<Bone> Bones;
+	};
+
+	// Process wide cache of parsed Basepose files, shared by all Converters and threads.
+	// Entries are held by reference count and dropped once no one uses them anymore
+	class BaseposeCache
+	{
+	public:
+		// Parses the given MSH only if it isn't cached yet, or has been modified since.
+		// Returns nullptr if the file can't be read
+		static std::shared_ptr<const ParsedBasepose> Get(const fs::path& mshFileName);
+
+	private:
+		struct Entry
+		{
+			fs::file_time_type WriteTime;
+			std::weak_ptr<const ParsedBasepose> Pose;
+		};
+
+		static std::mutex EntriesMutex;
+		static map<string, Entry> Entries;
+
+		static std::shared_ptr<const ParsedBasepose> Parse(const fs::path& mshFileName);
+	};
+}
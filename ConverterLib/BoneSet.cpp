@@ -0,0 +1,86 @@
+#include "stdafx.h"
+#include "BoneSet.h"
+
+namespace ConverterLib
+{
+	// CRCs are already well distributed, just fold all bits into 8
+	static inline uint8_t SignatureBit(const CRCChecksum crc)
+	{
+		return (uint8_t)(crc ^ (crc >> 8) ^ (crc >> 16) ^ (crc >> 24));
+	}
+
+	void BoneSet::Clear()
+	{
+		CRCs.clear();
+		Signature[0] = Signature[1] = Signature[2] = Signature[3] = 0;
+		bSorted = true;
+	}
+
+	void BoneSet::Add(const CRCChecksum crc)
+	{
+		if (!CRCs.empty() && CRCs.back() >= crc)
+		{
+			bSorted = false;
+		}
+		CRCs.push_back(crc);
+
+		const uint8_t bit = SignatureBit(crc);
+		Signature[bit >> 6] |= 1ull << (bit & 63);
+	}
+
+	void BoneSet::Build()
+	{
+		if (!bSorted)
+		{
+			std::sort(CRCs.begin(), CRCs.end());
+			CRCs.erase(std::unique(CRCs.begin(), CRCs.end()), CRCs.end());
+			bSorted = true;
+		}
+	}
+
+	size_t BoneSet::Size() const
+	{
+		return CRCs.size();
+	}
+
+	size_t BoneSet::CountShared(const BoneSet& other) const
+	{
+		if (((Signature[0] & other.Signature[0]) | (Signature[1] & other.Signature[1]) |
+			 (Signature[2] & other.Signature[2]) | (Signature[3] & other.Signature[3])) == 0)
+		{
+			return 0;
+		}
+
+		// merge walk over both sorted sets
+		size_t count = 0;
+		auto a = CRCs.begin();
+		auto b = other.CRCs.begin();
+		while (a != CRCs.end() && b != other.CRCs.end())
+		{
+			if (*a < *b)
+			{
+				++a;
+			}
+			else if (*b < *a)
+			{
+				++b;
+			}
+			else
+			{
+				++count;
+				++a;
+				++b;
+			}
+		}
+		return count;
+	}
+
+	float BoneSet::CoverageIn(const BoneSet& other) const
+	{
+		if (CRCs.empty())
+		{
+			return 1.0f;
+		}
+		return (float)CountShared(other) / CRCs.size();
+	}
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+namespace ConverterLib
+{
+	using LibSWBF2::CRCChecksum;
+
+	// Compact set of bone CRCs, to quickly tell how well an Animation
+	// fits a Skeleton before converting any of its keyframes.
+	// Besides the sorted CRCs, a 256 bit signature (one bit per CRC)
+	// lets disjoint sets be rejected without comparing any CRC.
+	class BoneSet
+	{
+	public:
+		void Clear();
+		void Add(const CRCChecksum crc);
+
+		// CRCs given in ascending order (e.g. the keys of a map)
+		// can be added in linear time, everything else is sorted here
+		void Build();
+
+		size_t Size() const;
+		size_t CountShared(const BoneSet& other) const;
+
+		// Fraction of this sets bones which are also in 'other' (0.0 - 1.0).
+		// An empty set is fully covered
+		float CoverageIn(const BoneSet& other) const;
+
+	private:
+		vector<CRCChecksum> CRCs;
+		uint64_t Signature[4] = { 0, 0, 0, 0 };
+		bool bSorted = true;
+	};
+}
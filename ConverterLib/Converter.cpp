@@ -1,15 +1,36 @@
 #include "stdafx.h"
+#include "BoneSet.h"
+#include "ThreadPool.h"
+#include "TransformCache.h"
+#include "BaseposeCache.h"
+#include "NameCRC.h"
+#include "FbxMemoryPool.h"
+#include "MappedFile.h"
+#include "MSHScanner.h"
 #include "Converter.h"
+#include "GeometryKernels.h"
+#include "AnimationKernels.h"
 
 namespace ConverterLib
 {
 	LogCallback Converter::OnLogCallback = nullptr;
 
+	// User properties on every FbxAnimStack, for incremental updates
+	static const char* StackSourceProperty = "MSH2FBX_Source";
+	static const char* StackHashProperty = "MSH2FBX_SourceHash";
+	static const char* StackSizeProperty = "MSH2FBX_SourceSize";
+	static const char* StackTimeProperty = "MSH2FBX_SourceTime";
+
 	Converter::Converter()
 	{
 		// pipe LibSWBF2 logs to our log
 		Logger::SetLogfileLevel(ELogType::Warning);
 		Logger::SetLogCallback(&ReceiveLogFromLib);
+
+		if (!NameCRC::IsCompatible())
+		{
+			Log("Name CRCs don't match the ones of LibSWBF2! Falling back to LibSWBF2's slower implementation.", ELogType::Warning);
+		}
 	}
 
 	void Converter::ReceiveLogFromLib(const LoggerEntry* entry)
@@ -25,6 +46,16 @@ namespace ConverterLib
 	Converter::~Converter()
 	{
 		Close();
+
+		if (Manager != nullptr)
+		{
+			// destroys the IO settings along with it
+			Exporter->Destroy();
+			Exporter = nullptr;
+			Manager->Destroy();
+			Manager = nullptr;
+			IOSettings = nullptr;
+		}
 	}
 
 	void Converter::Log(const string& msg, ELogType type)
@@ -166,12 +197,6 @@ namespace ConverterLib
 			return false;
 		}
 
-		if (Manager != nullptr)
-		{
-			Log("Manager is not NULL!", ELogType::Error);
-			return false;
-		}
-
 		if (Mesh != nullptr)
 		{
 			Log("Still a MSH present!", ELogType::Error);
@@ -185,15 +210,46 @@ namespace ConverterLib
 
 		MODLToFbxNode.clear();
 		CRCToFbxNode.clear();
+		MaterialCache.clear();
+		TextureCache.clear();
+		CurveCache.clear();
+		SkeletonBones.Clear();
+		SkeletonBonesSize = 0;
+		Transforms.Invalidate();
 		FbxFilePath = fbxFilePath;
 
-		// Overall FBX (memory) manager
-		Manager = FbxManager::Create();
+		// Workers are kept alive across Start/Close, as long as the count fits
+		const size_t numThreads = NumThreads > 0 ? NumThreads : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+		if (Workers == nullptr || Workers->NumThreads() != numThreads)
+		{
+			Workers = std::make_unique<ThreadPool>(numThreads);
+		}
+
+		// Overall FBX (memory) manager. It lives as long as this Converter, along
+		// with the IO settings and the exporter, only the Scene is per Start/Close
+		if (Manager == nullptr)
+		{
+			Manager = FbxManager::Create();
+
+			IOSettings = FbxIOSettings::Create(Manager, IOSROOT);
+			IOSettings->SetBoolProp(EXP_FBX_MATERIAL, true);
+			IOSettings->SetBoolProp(EXP_FBX_TEXTURE, true);
+			IOSettings->SetBoolProp(EXP_FBX_ANIMATION, true);
+			IOSettings->SetBoolProp(EXP_FBX_GLOBAL_SETTINGS, true);
+			Manager->SetIOSettings(IOSettings);
+
+			Exporter = FbxExporter::Create(Manager, "");
+		}
 
+		// Parsed once, shared with all other Converters using the same file. The previous
+		// Basepose is held across Close, so the cache hands it back as long as the file is unchanged
 		if (fs::exists(BaseposeMSH))
 		{
-			Basepose = MSH::Create();
-			Basepose->ReadFromFile(BaseposeMSH.u8string().c_str());
+			Basepose = BaseposeCache::Get(BaseposeMSH);
+		}
+		else
+		{
+			Basepose.reset();
 		}
 
 		// Create FBX Scene
@@ -204,6 +260,23 @@ namespace ConverterLib
 	}
 
 	bool Converter::AddMSH(const fs::path& mshFilePath)
+	{
+		if (!bTagSources)
+		{
+			return AddMSH(mshFilePath, SourceInfo());
+		}
+
+		// an untagged Stack could never be updated or removed again
+		SourceInfo source;
+		if (!ReadSourceInfo(mshFilePath, source) || (source.Hash = HashFile(mshFilePath)) == "")
+		{
+			Log("Could not hash MSH file '" + mshFilePath.u8string() + "' to tag its Animations!", ELogType::Error);
+			return false;
+		}
+		return AddMSH(mshFilePath, source);
+	}
+
+	bool Converter::AddMSH(const fs::path& mshFilePath, const SourceInfo& sourceInfo)
 	{
 		if (Mesh != nullptr)
 		{
@@ -217,16 +290,55 @@ namespace ConverterLib
 			return false;
 		}
 
-		Mesh = MSH::Create();
-		Mesh->ReadFromFile(mshFilePath.u8string().c_str());
+		CurrentSource = SourceKey(mshFilePath);
+		CurrentSourceInfo = sourceInfo;
+
+		ReadMSH(mshFilePath);
+		bOwnsMesh = true;
 		MSHToFBXScene();
 
 		MSH::Destroy(Mesh);
 		Mesh = nullptr;
+		bOwnsMesh = false;
+		MappedGeometry.clear();
+		MappedMSH.Close();
+
+		CurrentSource = "";
+		CurrentSourceInfo = SourceInfo();
 
 		return true;
 	}
 
+	void Converter::ReadMSH(const fs::path& mshFilePath)
+	{
+		Mesh = MSH::Create();
+
+		// Decode only the chunks the filters let through: Animation only conversions
+		// need nothing but the Animation chunks, and ignored Models not their geometry
+		if (bLazyParsing)
+		{
+			const bool bModels = (ChunkFilter & EChunkFilter::Models) == 0;
+			const bool bAnimations = (ChunkFilter & EChunkFilter::Animations) == 0;
+			const bool bWeights = (ChunkFilter & EChunkFilter::Weights) == 0;
+
+			// segment geometry is read in place, so the file stays mapped until the MSH is converted
+			if (MappedMSH.Open(mshFilePath) &&
+				(!bModels || MappedMSH.ReadMeshBlock(Mesh->m_MeshBlock, ModelIgnoreFilter, bWeights, MappedGeometry)) &&
+				(!bAnimations || MappedMSH.ReadAnimations(Mesh->m_Animations)))
+			{
+				return;
+			}
+
+			Log("Could not scan the chunks of '" + mshFilePath.u8string() + "', reading the whole file instead.", ELogType::Warning);
+			MappedGeometry.clear();
+			MappedMSH.Close();
+			MSH::Destroy(Mesh);
+			Mesh = MSH::Create();
+		}
+
+		Mesh->ReadFromFile(mshFilePath.u8string().c_str());
+	}
+
 	bool Converter::AddMSH(MSH* msh)
 	{
 		if (Mesh != nullptr)
@@ -248,6 +360,11 @@ namespace ConverterLib
 	}
 
 	bool Converter::SaveFBX()
+	{
+		return SaveFBX(FbxFilePath);
+	}
+
+	bool Converter::SaveFBX(const fs::path& fbxFilePath)
 	{
 		if (Scene == nullptr)
 		{
@@ -267,45 +384,34 @@ namespace ConverterLib
 			return false;
 		}
 
-		if (FbxFilePath == "")
+		if (fbxFilePath == "")
 		{
 			Log("No Fbx File Name present!", ELogType::Error);
 		}
 
 		bool success = true;
 
-		// Export Scene to FBX
-		FbxExporter* exporter = FbxExporter::Create(Manager, "");
-		FbxIOSettings* settings = FbxIOSettings::Create(Manager, IOSROOT);
-		settings->SetBoolProp(EXP_FBX_MATERIAL, true);
-		settings->SetBoolProp(EXP_FBX_TEXTURE, true);
-		settings->SetBoolProp(EXP_FBX_ANIMATION, true);
-		settings->SetBoolProp(EXP_FBX_GLOBAL_SETTINGS, true);
-		Manager->SetIOSettings(settings);
-
 		if (bPrintHierachy)
 		{
-			Log("Hierarchy of '"+ FbxFilePath.u8string() +"':", ELogType::Info);
+			Log("Hierarchy of '"+ fbxFilePath.u8string() +"':", ELogType::Info);
 		}
 		CheckHierarchy();
 
-		if (exporter->Initialize(FbxFilePath.u8string().c_str(), -1, Manager->GetIOSettings()))
+		// Export Scene to FBX. The exporter is reused, initializing it again for every file
+		if (Exporter->Initialize(fbxFilePath.u8string().c_str(), -1, IOSettings))
 		{
-			exporter->SetFileExportVersion(FBX_2011_00_COMPATIBLE);
-			if (!exporter->Export(Scene, false))
+			Exporter->SetFileExportVersion(FBX_2011_00_COMPATIBLE);
+			if (!Exporter->Export(Scene, false))
 			{
-				Log("Exporting failed!\n" + string(exporter->GetStatus().GetErrorString()), ELogType::Error);
+				Log("Exporting failed!\n" + string(Exporter->GetStatus().GetErrorString()), ELogType::Error);
 				success = false;
 			}
 		}
 		else
 		{
-			Log("Initializing export failed!\n" + string(exporter->GetStatus().GetErrorString()), ELogType::Error);
+			Log("Initializing export failed!\n" + string(Exporter->GetStatus().GetErrorString()), ELogType::Error);
 			success = false;
 		}
-
-		// Free all
-		exporter->Destroy();
 		return success;
 	}
 
@@ -323,214 +429,570 @@ namespace ConverterLib
 		return true;
 	}
 
-	void Converter::Close()
+	void Converter::ClearAnimations()
 	{
-		if (!bRunning)
+		if (Scene == nullptr)
 		{
+			Log("Scene is NULL!", ELogType::Error);
 			return;
 		}
-		if (Scene == nullptr)
+
+		// Destroy from the back, since destroying removes the object from the Scene
+		for (int i = Scene->GetSrcObjectCount<FbxAnimCurve>() - 1; i >= 0; --i)
 		{
-			Log("Cannot close Scene since its NULL!", ELogType::Error);
-			return;
+			Scene->GetSrcObject<FbxAnimCurve>(i)->Destroy();
+		}
+		for (int i = Scene->GetSrcObjectCount<FbxAnimCurveNode>() - 1; i >= 0; --i)
+		{
+			Scene->GetSrcObject<FbxAnimCurveNode>(i)->Destroy();
+		}
+		for (int i = Scene->GetSrcObjectCount<FbxAnimLayer>() - 1; i >= 0; --i)
+		{
+			Scene->GetSrcObject<FbxAnimLayer>(i)->Destroy();
+		}
+		for (int i = Scene->GetSrcObjectCount<FbxAnimStack>() - 1; i >= 0; --i)
+		{
+			Scene->GetSrcObject<FbxAnimStack>(i)->Destroy();
 		}
 
-		if (Manager == nullptr)
+		CurveCache.clear();
+		SourceStacks.clear();
+	}
+
+	bool Converter::LoadFBX(const fs::path& fbxFilePath)
+	{
+		if (!bRunning)
 		{
-			Log("Cannot close Scene since its NULL!", ELogType::Error);
-			return;
+			Log("Cannot load into a not running Converter instance!", ELogType::Error);
+			return false;
 		}
 
-		if (Basepose != nullptr)
+		if (!fs::exists(fbxFilePath))
 		{
-			MSH::Destroy(Basepose);
+			Log("Given FBX file '" + fbxFilePath.u8string() + "' does not exist!", ELogType::Error);
+			return false;
 		}
 
-		// Free all
-		Scene->Destroy();
-		Scene = nullptr;
+		bool success = true;
 
-		Manager->Destroy();
-		Manager = nullptr;
+		FbxImporter* importer = FbxImporter::Create(Manager, "");
+		if (!importer->Initialize(fbxFilePath.u8string().c_str(), -1, IOSettings))
+		{
+			Log("Initializing import failed!\n" + string(importer->GetStatus().GetErrorString()), ELogType::Error);
+			success = false;
+		}
+		else if (!importer->Import(Scene))
+		{
+			Log("Importing failed!\n" + string(importer->GetStatus().GetErrorString()), ELogType::Error);
+			success = false;
+		}
+		importer->Destroy();
 
-		Mesh = nullptr;
-		FbxFilePath = "";
-		bRunning = false;
+		// Bones are found via the CRC of their names, just like the ones converted from MSH
+		function<void(FbxNode*)> mapNodesRecursive = [&](FbxNode* node)
+		{
+			for (int i = 0; i < node->GetChildCount(); ++i)
+			{
+				FbxNode* child = node->GetChild(i);
+				CRCToFbxNode[NameCRC::CalcLowerCRC(child->GetName())] = child;
+				mapNodesRecursive(child);
+			}
+		};
+		mapNodesRecursive(Scene->GetRootNode());
+		Transforms.Invalidate();
+
+		// index the Stacks by their source once, instead of searching them for every MSH
+		SourceStacks.clear();
+		for (int i = 0; i < Scene->GetSrcObjectCount<FbxAnimStack>(); ++i)
+		{
+			FbxAnimStack* animStack = Scene->GetSrcObject<FbxAnimStack>(i);
+			const string source = GetStackProperty(animStack, StackSourceProperty);
+			if (source != "")
+			{
+				SourceStacks[source].push_back(animStack);
+			}
+		}
+
+		return success;
 	}
 
-	void Converter::MSHToFBXScene()
+	bool Converter::UpdateMSH(const fs::path& mshFilePath)
 	{
-		FbxNode* rootNode = Scene->GetRootNode();
-		map<MODL*, FbxCluster*> BoneToCluster;
+		if (!bRunning)
+		{
+			Log("Cannot update a not running Converter instance!", ELogType::Error);
+			return false;
+		}
 
-		// Converting Models
-		if ((ChunkFilter & EChunkFilter::Models) == 0)
+		if (!fs::exists(mshFilePath))
 		{
-			// Since we have to loop through all MSH models multiple times (duh!)
-			// lets just remember all processed models (according to filter)
-			// so we don't have to re-filter in the other loops again
-			vector<MODL*> processingModels;
+			Log("Given MSH file '" + mshFilePath.u8string() + "' does not exist!", ELogType::Error);
+			return false;
+		}
 
-			for (size_t i = 0; i < Mesh->m_MeshBlock.m_Models.Size(); ++i)
-			{
-				MODL& model = Mesh->m_MeshBlock.m_Models[i];
-				EModelPurpose purpose = model.GetPurpose();
+		// most files didn't change since the last update, which size and
+		// modification time usually tell without reading the whole file
+		SourceInfo info;
+		if (!ReadSourceInfo(mshFilePath, info))
+		{
+			Log("Could not read size and modification time of MSH file '" + mshFilePath.u8string() + "'!", ELogType::Error);
+			return false;
+		}
 
-				// generate crc checksum from name (should match those in msh file)
-				CRCChecksum crc = CRC::CalcLowerCRC(model.m_Name.m_Text.Buffer());
+		auto it = SourceStacks.find(SourceKey(mshFilePath));
+		if (it != SourceStacks.end() && GetStackProperty(it->second[0], StackSizeProperty) == info.Size && GetStackProperty(it->second[0], StackTimeProperty) == info.Time)
+		{
+			return true;
+		}
 
-				// Do not process unwanted stuff
-				// Do not process the same Bone more than once
-				if ((purpose & ModelIgnoreFilter) != 0 || ((purpose & EModelPurpose::Skeleton) != 0 && FindNode(crc) != nullptr))
-				{
-					continue;
-				}
+		info.Hash = HashFile(mshFilePath);
+		if (info.Hash == "")
+		{
+			Log("Could not hash MSH file '" + mshFilePath.u8string() + "' to tag its Animations!", ELogType::Error);
+			return false;
+		}
 
-				// Create Node to attach mesh to
-				FbxNode* modelNode = FbxNode::Create(Manager, model.m_Name.m_Text.Buffer());
-				rootNode->AddChild(modelNode);
+		if (it != SourceStacks.end() && GetStackProperty(it->second[0], StackHashProperty) == info.Hash)
+		{
+			// touched, but not changed. Remember the new time, so it isn't hashed again next time
+			for (FbxAnimStack* animStack : it->second)
+			{
+				SetStackProperty(animStack, StackSizeProperty, info.Size);
+				SetStackProperty(animStack, StackTimeProperty, info.Time);
+			}
+			return true;
+		}
 
-				if ((purpose & EModelPurpose::Mesh) != 0)
-				{
-					if (bEmptyMeshes)
-					{
-						FbxMesh* mesh = FbxMesh::Create(Manager, model.m_Name.m_Text.Buffer());
-						modelNode->AddNodeAttribute(mesh);
-					}
+		RemoveAnimations(mshFilePath);
+		return AddMSH(mshFilePath, info);
+	}
 
-					// Create and attach Mesh
-					else if (!MODLToFBXMesh(model, Mesh->m_MeshBlock.m_MaterialList, modelNode))
-					{
-						Log("Failed to convert MSH Model to FBX Mesh. MODL No: " + std::to_string(i) + "  MTYP: " + std::to_string((int)model.m_ModelType.m_ModelType), ELogType::Warning);
-						continue;
-					}
-				}
-				else if ((purpose & EModelPurpose::Skeleton) != 0)
-				{
-					// Create FBXSkeleton (Bones)
-					if (!MODLToFBXSkeleton(model, modelNode))
-					{
-						Log("Failed to convert MSH Model to FBX Skeleton. MODL No: " + std::to_string(i) + "  MTYP: " + std::to_string((int)model.m_ModelType.m_ModelType), ELogType::Warning);
-						continue;
-					}
-				}
-				else // everything else is just interpreted as a point with an empty mesh
-				{
-					FbxMesh* mesh = FbxMesh::Create(Manager, model.m_Name.m_Text.Buffer());
-					modelNode->AddNodeAttribute(mesh);
-				}
+	void Converter::RemoveAnimations(const fs::path& mshFilePath)
+	{
+		if (!bRunning)
+		{
+			Log("Cannot remove Animations from a not running Converter instance!", ELogType::Error);
+			return;
+		}
 
-				processingModels.emplace_back(&model); 
-				CRCToFbxNode[crc] = modelNode;
-				MODLToFbxNode[&model] = modelNode;
+		auto it = SourceStacks.find(SourceKey(mshFilePath));
+		if (it != SourceStacks.end())
+		{
+			// destroying removes the Stacks from the index
+			const vector<FbxAnimStack*> animStacks = it->second;
+			for (FbxAnimStack* animStack : animStacks)
+			{
+				DestroyAnimStack(animStack);
 			}
+		}
+	}
 
-			// Applying Transforms and Parentships
-			// Maybe doing something more efficient in the future?
-			for (size_t i = 0; i < processingModels.size(); ++i)
+	void Converter::RemoveAnimationsExcept(const vector<fs::path>& mshFilePaths)
+	{
+		if (!bRunning)
+		{
+			Log("Cannot remove Animations from a not running Converter instance!", ELogType::Error);
+			return;
+		}
+
+		std::set<string> keep;
+		for (const fs::path& mshFilePath : mshFilePaths)
+		{
+			keep.insert(SourceKey(mshFilePath));
+		}
+
+		// Stacks without a source (not converted by us) aren't indexed, so they're left alone
+		vector<FbxAnimStack*> remove;
+		for (const auto& [source, animStacks] : SourceStacks)
+		{
+			if (keep.find(source) == keep.end())
 			{
-				MODL* model = processingModels[i];
-				EModelPurpose purpose = model->GetPurpose();
+				Log("Removing the Animations of '" + source + "', since it's not given any more", ELogType::Info);
+				remove.insert(remove.end(), animStacks.begin(), animStacks.end());
+			}
+		}
 
-				FbxNode* modelNode = FindNode(model);
-				if (modelNode == nullptr)
-				{
-					Log("No FbxNode has been created for MODL '" + string(model->m_Parent.m_Text.Buffer()) + "' ! This should never happen!", ELogType::Error);
-					continue;
-				}
+		for (FbxAnimStack* animStack : remove)
+		{
+			DestroyAnimStack(animStack);
+		}
+	}
 
-				// Change parentship (if any)
-				if (model->m_Parent.m_Text != "")
-				{
-					// Get FBXNode of Parent
-					FbxNode* parentNode = rootNode->FindChild(model->m_Parent.m_Text.Buffer());
+	void Converter::RemoveMissingSources()
+	{
+		if (!bRunning)
+		{
+			Log("Cannot remove Animations from a not running Converter instance!", ELogType::Error);
+			return;
+		}
 
-					if (parentNode != nullptr)
-					{
-						//Log(parentNode->GetName() + string(" --> ") + modelNode->GetName(), ELogType::Info);
-						rootNode->RemoveChild(modelNode);
-						parentNode->AddChild(modelNode);
-					}
-					else
-					{
-						Log("Parent Node '" + string(model->m_Parent.m_Text.Buffer()) + "' not found!", ELogType::Warning);
-					}
-				}
+		// sources are relative to the FBX files directory (see SourceKey),
+		// appending an absolute one just yields that
+		std::error_code error;
+		fs::path directory = fs::weakly_canonical(FbxFilePath, error).parent_path();
+		if (error)
+		{
+			directory = FbxFilePath.parent_path();
+		}
 
-				// Applying MODL Transform to FbxNode
-				ApplyTransform(
-					modelNode, 
-					model->m_Transition.m_Translation, 
-					model->m_Transition.m_Rotation,
-					model->m_Transition.m_Scale
-				);
+		vector<FbxAnimStack*> remove;
+		for (const auto& [source, animStacks] : SourceStacks)
+		{
+			// a file that can't be checked isn't taken for gone
+			const bool exists = fs::exists(directory / fs::u8path(source), error);
+			if (!exists && !error)
+			{
+				Log("Removing the Animations of '" + source + "', since that file is gone", ELogType::Info);
+				remove.insert(remove.end(), animStacks.begin(), animStacks.end());
 			}
+		}
 
-			// Apply Basepose to all Bones BEFORE applying Mesh Weights!
-			if (Basepose != nullptr)
+		for (FbxAnimStack* animStack : remove)
+		{
+			DestroyAnimStack(animStack);
+		}
+	}
+
+	void Converter::DestroyAnimStack(FbxAnimStack* animStack)
+	{
+		auto it = SourceStacks.find(GetStackProperty(animStack, StackSourceProperty));
+		if (it != SourceStacks.end())
+		{
+			vector<FbxAnimStack*>& animStacks = it->second;
+			animStacks.erase(std::remove(animStacks.begin(), animStacks.end(), animStack), animStacks.end());
+			if (animStacks.empty())
+			{
+				SourceStacks.erase(it);
+			}
+		}
+
+		// curves might be shared with other Stacks (see bShareCurves), or be used by
+		// several channels of this one. Only the ones no channel is left for get destroyed
+		vector<FbxAnimCurve*> curves;
+		for (int i = animStack->GetMemberCount<FbxAnimLayer>() - 1; i >= 0; --i)
+		{
+			FbxAnimLayer* animLayer = animStack->GetMember<FbxAnimLayer>(i);
+			for (int j = animLayer->GetMemberCount<FbxAnimCurveNode>() - 1; j >= 0; --j)
 			{
-				List<BoneFrames>& BoneFrames = Basepose->m_Animations.m_KeyFrames.m_BoneFrames;
-				if (BoneFrames.Size() > 0)
+				FbxAnimCurveNode* curveNode = animLayer->GetMember<FbxAnimCurveNode>(j);
+				for (unsigned int c = 0; c < curveNode->GetChannelsCount(); ++c)
 				{
-					// for every bone...
-					for (size_t i = 0; i < BoneFrames.Size(); ++i)
+					for (int k = 0; k < curveNode->GetCurveCount(c); ++k)
 					{
-						FbxNode* boneNode = FindNode(BoneFrames[i].m_CRCchecksum);
-
-						if (boneNode == nullptr)
+						FbxAnimCurve* curve = curveNode->GetCurve(c, k);
+						if (std::find(curves.begin(), curves.end(), curve) == curves.end())
 						{
-							Log("Could not find a Bone for CRC: " + std::to_string(BoneFrames[i].m_CRCchecksum), ELogType::Warning);
-							continue;
+							curves.push_back(curve);
 						}
+					}
+				}
+				curveNode->Destroy();
+			}
+			animLayer->Destroy();
+		}
+		animStack->Destroy();
 
-						if (BoneFrames[i].m_TranslationFrames.Size() == 0)
-						{
-							Log("Given Basepose file does not contain any Bone Translation Data!", ELogType::Warning);
-						}
-						else if (BoneFrames[i].m_RotationFrames.Size() == 0)
+		for (FbxAnimCurve* curve : curves)
+		{
+			if (CountCurveNodeChannels(curve) == 0)
+			{
+				curve->Destroy();
+			}
+		}
+
+		// the cache might point to destroyed curves now
+		CurveCache.clear();
+	}
+
+	// Curves are connected to the channel properties of their curve nodes,
+	// not to the nodes themselves
+	int Converter::CountCurveNodeChannels(FbxAnimCurve* curve)
+	{
+		int count = 0;
+		for (int i = 0; i < curve->GetDstPropertyCount(); ++i)
+		{
+			FbxObject* owner = curve->GetDstProperty(i).GetFbxObject();
+			if (owner != nullptr && owner->Is<FbxAnimCurveNode>())
+			{
+				++count;
+			}
+		}
+		return count;
+	}
+
+	// Relative to the FBX files directory, so keys neither depend on the working
+	// directory nor on how the path was given, and survive moving the whole folder
+	string Converter::SourceKey(const fs::path& mshFilePath) const
+	{
+		std::error_code error;
+		const fs::path source = fs::weakly_canonical(mshFilePath, error);
+		if (error)
+		{
+			return mshFilePath.lexically_normal().generic_u8string();
+		}
+
+		if (FbxFilePath != "")
+		{
+			const fs::path directory = fs::weakly_canonical(FbxFilePath, error).parent_path();
+			const fs::path relative = source.lexically_relative(directory);
+
+			// on another drive, there's no relative path
+			if (!error && !relative.empty())
+			{
+				return relative.generic_u8string();
+			}
+		}
+		return source.generic_u8string();
+	}
+
+	string Converter::HashFile(const fs::path& mshFilePath)
+	{
+		MappedFile file;
+		if (!file.Open(mshFilePath))
+		{
+			return "";
+		}
+
+		// FNV-1a
+		uint64_t hash = 14695981039346656037ull;
+		const uint8_t* data = file.GetData();
+		for (size_t i = 0; i < file.GetSize(); ++i)
+		{
+			hash ^= data[i];
+			hash *= 1099511628211ull;
+		}
+
+		char hex[17];
+		snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)hash);
+		return hex;
+	}
+
+	bool Converter::ReadSourceInfo(const fs::path& mshFilePath, SourceInfo& info)
+	{
+		std::error_code error;
+		const uintmax_t size = fs::file_size(mshFilePath, error);
+		if (error)
+		{
+			return false;
+		}
+
+		const fs::file_time_type time = fs::last_write_time(mshFilePath, error);
+		if (error)
+		{
+			return false;
+		}
+
+		info.Size = std::to_string(size);
+		info.Time = std::to_string(time.time_since_epoch().count());
+		return true;
+	}
+
+	string Converter::GetStackProperty(FbxAnimStack* animStack, const char* name)
+	{
+		FbxProperty property = animStack->FindProperty(name, false);
+		if (!property.IsValid())
+		{
+			return "";
+		}
+		return property.Get<FbxString>().Buffer();
+	}
+
+	void Converter::SetStackProperty(FbxAnimStack* animStack, const char* name, const string& value)
+	{
+		FbxProperty property = animStack->FindProperty(name, false);
+		if (!property.IsValid())
+		{
+			property = FbxProperty::Create(animStack, FbxStringDT, name);
+			property.ModifyFlag(FbxPropertyFlags::eUserDefined, true);
+		}
+		property.Set(FbxString(value.c_str()));
+	}
+
+	void Converter::Close()
+	{
+		if (!bRunning)
+		{
+			return;
+		}
+		if (Scene == nullptr)
+		{
+			Log("Cannot close Scene since its NULL!", ELogType::Error);
+			return;
+		}
+
+		if (Manager == nullptr)
+		{
+			Log("Cannot close Scene since its NULL!", ELogType::Error);
+			return;
+		}
+
+		// Free the Scene and everything in it. The Manager is kept for the next Start
+		Scene->Destroy();
+		Scene = nullptr;
+		Bindpose = nullptr;
+		SourceStacks.clear();
+		FbxMemoryPool::Trim();
+
+		Mesh = nullptr;
+		FbxFilePath = "";
+		bRunning = false;
+	}
+
+	void Converter::MSHToFBXScene()
+	{
+		// Resolve the filters once per MSH, everything below runs
+		// on a path specialized for exactly this filter combination
+		const uint8_t filter = ChunkFilter & (EChunkFilter::Materials | EChunkFilter::Models | EChunkFilter::Animations | EChunkFilter::Weights);
+		if (bEmptyMeshes)
+		{
+			MSHToFBXScene<true>(filter, std::make_index_sequence<16>());
+		}
+		else
+		{
+			MSHToFBXScene<false>(filter, std::make_index_sequence<16>());
+		}
+	}
+
+	template<bool bEmpty, size_t... Filters>
+	void Converter::MSHToFBXScene(const uint8_t filter, std::index_sequence<Filters...>)
+	{
+		((filter == Filters ? (MSHToFBXScene<(uint8_t)Filters, bEmpty>(), true) : false) || ...);
+	}
+
+	template<uint8_t Filter, bool bEmpty>
+	void Converter::MSHToFBXScene()
+	{
+		FbxNode* rootNode = Scene->GetRootNode();
+		map<MODL*, FbxCluster*> BoneToCluster;
+
+		// Converting Models
+		if constexpr ((Filter & EChunkFilter::Models) == 0)
+		{
+			// Since we have to loop through all MSH models multiple times (duh!)
+			// lets just remember all processed models (according to filter)
+			// so we don't have to re-filter in the other loops again
+			vector<size_t> processingModels;
+
+			// Meshes are independent of each other, so their geometry is prepared in
+			// parallel, a batch of a few models per thread at a time. Each batch is
+			// consumed before the next one is prepared, bounding the memory held in between
+			List<MODL>& models = Mesh->m_MeshBlock.m_Models;
+			const size_t batchSize = Workers->NumThreads() * 4;
+			vector<PreparedMesh> preparedMeshes;
+			size_t batchBegin = 0;
+
+			// generate crc checksums from names (should match those in msh file).
+			// Envelopes refer to their bones by model index, so compute them just once
+			ModelCRCs.resize(models.Size());
+			for (size_t i = 0; i < models.Size(); ++i)
+			{
+				ModelCRCs[i] = NameCRC::CalcLowerCRC(models[i].m_Name.m_Text.Buffer());
+			}
+
+			for (size_t i = 0; i < Mesh->m_MeshBlock.m_Models.Size(); ++i)
+			{
+				if constexpr (!bEmpty)
+				{
+					if (!bLowMemory && i % batchSize == 0)
+					{
+						batchBegin = i;
+						preparedMeshes.clear();
+						preparedMeshes.resize(std::min(batchSize, models.Size() - i));
+						Workers->ParallelFor(preparedMeshes.size(), [&](const size_t begin, const size_t end)
 						{
-							Log("Given Basepose file does not contain any Bone Rotation Data!", ELogType::Warning);
+							for (size_t j = begin; j < end; ++j)
+							{
+								MODL& batchModel = models[batchBegin + j];
+								EModelPurpose purpose = batchModel.GetPurpose();
+								if ((purpose & ModelIgnoreFilter) == 0 && (purpose & EModelPurpose::Mesh) != 0)
+								{
+									PrepareMesh(batchModel, GetSegmentGeometry(batchBegin + j), preparedMeshes[j]);
+								}
+							}
+						});
+					}
+				}
+
+				MODL& model = Mesh->m_MeshBlock.m_Models[i];
+				EModelPurpose purpose = model.GetPurpose();
+				const CRCChecksum crc = ModelCRCs[i];
+
+				// Do not process unwanted stuff
+				// Do not process the same Bone more than once
+				if ((purpose & ModelIgnoreFilter) != 0 || ((purpose & EModelPurpose::Skeleton) != 0 && FindNode(crc) != nullptr))
+				{
+					continue;
+				}
+
+				// Create Node to attach mesh to
+				FbxNode* modelNode = FbxNode::Create(Scene, model.m_Name.m_Text.Buffer());
+				rootNode->AddChild(modelNode);
+
+				if ((purpose & EModelPurpose::Mesh) != 0)
+				{
+					if constexpr (bEmpty)
+					{
+						FbxMesh* mesh = FbxMesh::Create(Scene, model.m_Name.m_Text.Buffer());
+						modelNode->AddNodeAttribute(mesh);
+					}
+
+					// Create and attach Mesh
+					else
+					{
+						bool bConverted;
+						if (bLowMemory)
+						{
+							bConverted = MODLToFBXMeshStreamed<(Filter & EChunkFilter::Materials) == 0>(model, GetSegmentGeometry(i), Mesh->m_MeshBlock.m_MaterialList, modelNode);
+
+							// the geometry lives in the FbxMesh now, except for what skinning still needs
+							if (bOwnsMesh)
+							{
+								ReleaseGeometry(model, (Filter & EChunkFilter::Weights) == 0);
+							}
 						}
 						else
 						{
-							// A Basepose file contains an Animation with only one Frame
-							// defining the Basepose. So ignore all possible other frames
-							Vector3& boneTranslation = BoneFrames[i].m_TranslationFrames[0].m_Translation;
-							Vector4& boneRotation = BoneFrames[i].m_RotationFrames[0].m_Rotation;
-							FbxVector4 rot(QuaternionToEuler(boneRotation));
+							PreparedMesh& prepared = preparedMeshes[i - batchBegin];
+							bConverted = MODLToFBXMesh<(Filter & EChunkFilter::Materials) == 0>(model, prepared, Mesh->m_MeshBlock.m_MaterialList, modelNode);
 
-							ApplyTransform(
-								boneNode,
-								boneTranslation,
-								boneRotation
-							);
+							// the geometry lives in the FbxMesh now
+							prepared = PreparedMesh();
+						}
 
-							// Ensure FBX Bindepose exists
-							if (Bindpose == nullptr)
-							{
-								Bindpose = FbxPose::Create(Scene, "Bindpose");
-								Bindpose->SetIsBindPose(true);
-								Scene->AddPose(Bindpose);
-							}
-							Bindpose->Add(boneNode, boneNode->EvaluateGlobalTransform(), false, false);
+						if (!bConverted)
+						{
+							Log("Failed to convert MSH Model to FBX Mesh. MODL No: " + std::to_string(i) + "  MTYP: " + std::to_string((int)model.m_ModelType.m_ModelType), ELogType::Warning);
+							continue;
 						}
 					}
 				}
-				else
+				else if ((purpose & EModelPurpose::Skeleton) != 0)
 				{
-					Log("Given Basepose file does not contain any Frame Data!", ELogType::Warning);
+					// Create FBXSkeleton (Bones)
+					if (!MODLToFBXSkeleton(model, modelNode))
+					{
+						Log("Failed to convert MSH Model to FBX Skeleton. MODL No: " + std::to_string(i) + "  MTYP: " + std::to_string((int)model.m_ModelType.m_ModelType), ELogType::Warning);
+						continue;
+					}
+				}
+				else // everything else is just interpreted as a point with an empty mesh
+				{
+					FbxMesh* mesh = FbxMesh::Create(Scene, model.m_Name.m_Text.Buffer());
+					modelNode->AddNodeAttribute(mesh);
 				}
-			}
 
+				processingModels.emplace_back(i);
+				CRCToFbxNode[crc] = modelNode;
+				MODLToFbxNode[&model] = modelNode;
+			}
 
-			// Applying Weights to all Meshes
-			// Execute this AFTER all Bones (MODLs) are converted to FbxNodes
-			// and their Transforms have been applied respectively!
+			// Applying Transforms and Parentships
+			// Maybe doing something more efficient in the future?
 			for (size_t i = 0; i < processingModels.size(); ++i)
 			{
-				MODL* model = processingModels[i];
+				MODL* model = &models[processingModels[i]];
 				EModelPurpose purpose = model->GetPurpose();
-				
+
 				FbxNode* modelNode = FindNode(model);
 				if (modelNode == nullptr)
 				{
@@ -538,34 +1000,148 @@ namespace ConverterLib
 					continue;
 				}
 
-				if ((ChunkFilter & EChunkFilter::Weights) == 0 && (purpose & EModelPurpose::Mesh) != 0)
+				// Change parentship (if any)
+				if (model->m_Parent.m_Text != "")
 				{
-					FbxAMatrix& matrixMeshNode = modelNode->EvaluateGlobalTransform();
-					size_t vertexOffset = 0;
+					// Get FBXNode of Parent
+					FbxNode* parentNode = rootNode->FindChild(model->m_Parent.m_Text.Buffer());
 
-					// Go through all Mesh Segments, grabbing Weight data
-					for (size_t i = 0; i < model->m_Geometry.m_Segments.Size(); ++i)
+					if (parentNode != nullptr)
 					{
-						SEGM& segment = model->m_Geometry.m_Segments[i];
-						WGHTToFBXSkin(segment.m_WeightList, model->m_Geometry.m_Envelope, matrixMeshNode, vertexOffset, BoneToCluster);
-						vertexOffset += segment.m_VertexList.m_Vertices.Size();
+						//Log(parentNode->GetName() + string(" --> ") + modelNode->GetName(), ELogType::Info);
+						rootNode->RemoveChild(modelNode);
+						parentNode->AddChild(modelNode);
+						Transforms.Invalidate();
+					}
+					else
+					{
+						Log("Parent Node '" + string(model->m_Parent.m_Text.Buffer()) + "' not found!", ELogType::Warning);
+					}
+				}
+
+				// Applying MODL Transform to FbxNode
+				ApplyTransform(
+					modelNode, 
+					model->m_Transition.m_Translation, 
+					model->m_Transition.m_Rotation,
+					model->m_Transition.m_Scale
+				);
+			}
+
+			// Apply Basepose to all Bones BEFORE applying Mesh Weights!
+			if (Basepose != nullptr)
+			{
+				const vector<ParsedBasepose::Bone>& bones = Basepose->Bones;
+				if (bones.size() > 0)
+				{
+					vector<FbxNode*> posedBones;
+
+					// for every bone...
+					for (const ParsedBasepose::Bone& bone : bones)
+					{
+						FbxNode* boneNode = FindNode(bone.CRC);
+
+						if (boneNode == nullptr)
+						{
+							Log("Could not find a Bone for CRC: " + std::to_string(bone.CRC), ELogType::Warning);
+							continue;
+						}
+
+						if (!bone.bHasTranslation)
+						{
+							Log("Given Basepose file does not contain any Bone Translation Data!", ELogType::Warning);
+						}
+						else if (!bone.bHasRotation)
+						{
+							Log("Given Basepose file does not contain any Bone Rotation Data!", ELogType::Warning);
+						}
+						else
+						{
+							ApplyTransform(
+								boneNode,
+								bone.Translation,
+								bone.Rotation
+							);
+							posedBones.push_back(boneNode);
+						}
+					}
+
+					// Bindpose entries are global transforms, so add them
+					// once the Basepose has been applied to all Bones
+					if (posedBones.size() > 0)
+					{
+						// Ensure FBX Bindepose exists
+						if (Bindpose == nullptr)
+						{
+							Bindpose = FbxPose::Create(Scene, "Bindpose");
+							Bindpose->SetIsBindPose(true);
+							Scene->AddPose(Bindpose);
+						}
+
+						for (FbxNode* boneNode : posedBones)
+						{
+							Bindpose->Add(boneNode, GetGlobalTransform(boneNode), false, false);
+						}
 					}
+				}
+				else
+				{
+					Log("Given Basepose file does not contain any Frame Data!", ELogType::Warning);
+				}
+			}
 
-					FbxSkin* skin = FbxSkin::Create(Scene, (string(model->m_Name.m_Text.Buffer()) + "_Skin").c_str());
 
-					for (auto it = BoneToCluster.begin(); it != BoneToCluster.end(); it++)
+			// Applying Weights to all Meshes
+			// Execute this AFTER all Bones (MODLs) are converted to FbxNodes
+			// and their Transforms have been applied respectively!
+			if constexpr ((Filter & EChunkFilter::Weights) == 0)
+			{
+				for (size_t i = 0; i < processingModels.size(); ++i)
+				{
+					MODL* model = &models[processingModels[i]];
+					EModelPurpose purpose = model->GetPurpose();
+				
+					FbxNode* modelNode = FindNode(model);
+					if (modelNode == nullptr)
 					{
-						skin->AddCluster(it->second);
+						Log("No FbxNode has been created for MODL '" + string(model->m_Parent.m_Text.Buffer()) + "' ! This should never happen!", ELogType::Error);
+						continue;
 					}
 
-					FbxMesh* mesh = (FbxMesh*)modelNode->GetNodeAttribute();
-					mesh->AddDeformer(skin);
+					if ((purpose & EModelPurpose::Mesh) != 0)
+					{
+						const FbxAMatrix& matrixMeshNode = GetGlobalTransform(modelNode);
+						const vector<SegmentGeometry> segments = GetSegmentGeometry(processingModels[i]);
+						size_t vertexOffset = 0;
+
+						// Go through all Mesh Segments, grabbing Weight data
+						for (size_t s = 0; s < segments.size(); ++s)
+						{
+							WGHTToFBXSkin(segments[s].Weights, segments[s].NumWeights, model->m_Geometry.m_Envelope, matrixMeshNode, vertexOffset, BoneToCluster);
+							vertexOffset += segments[s].NumVertices;
+						}
+
+						FbxSkin* skin = FbxSkin::Create(Scene, (string(model->m_Name.m_Text.Buffer()) + "_Skin").c_str());
+
+						for (auto it = BoneToCluster.begin(); it != BoneToCluster.end(); it++)
+						{
+							skin->AddCluster(it->second);
+						}
+
+						FbxMesh* mesh = (FbxMesh*)modelNode->GetNodeAttribute();
+						mesh->AddDeformer(skin);
+
+						if (bLowMemory && bOwnsMesh)
+						{
+							ReleaseGeometry(*model, false);
+						}
+					}
 				}
 			}
 		}
 
 		// Converting Animations
-		if ((ChunkFilter & EChunkFilter::Animations) == 0)
+		if constexpr ((Filter & EChunkFilter::Animations) == 0)
 		{
 			ANM2ToFBXAnimations(Mesh->m_Animations);
 		}
@@ -578,6 +1154,8 @@ namespace ConverterLib
 
 	FbxDouble4 Converter::QuaternionToEuler(const Vector4& Quaternion)
 	{
+		// single transforms (bind poses) are decomposed in double precision,
+		// only animation keys go through AnimationKernels::QuaternionsToEuler
 		FbxQuaternion quaternion;
 		quaternion.Set
 		(
@@ -604,6 +1182,7 @@ namespace ConverterLib
 			)
 		);
 		modelNode->LclRotation.Set(QuaternionToEuler(Rotation));
+		Transforms.Invalidate();
 	}
 
 	void Converter::ApplyTransform(FbxNode* modelNode, const Vector3& Translation, const Vector4& Rotation, const Vector3& Scale)
@@ -619,8 +1198,18 @@ namespace ConverterLib
 			)
 		);
 	}
+
+	const FbxAMatrix& Converter::GetGlobalTransform(FbxNode* node)
+	{
+		// rebuilt at once for all nodes, on first access after any change
+		if (!Transforms.IsValid())
+		{
+			Transforms.Build(Scene->GetRootNode());
+		}
+		return Transforms.GetGlobal(node);
+	}
 	
-	void Converter::WGHTToFBXSkin(WGHT& weights, const ENVL& envelope, const FbxAMatrix& matrixMeshNode, const size_t vertexOffset, map<MODL*, FbxCluster*>& BoneToCluster)
+	void Converter::WGHTToFBXSkin(const VertexWeights* weights, const size_t numWeights, const ENVL& envelope, const FbxAMatrix& matrixMeshNode, const size_t vertexOffset, map<MODL*, FbxCluster*>& BoneToCluster)
 	{
 		if (Mesh == nullptr)
 		{
@@ -629,13 +1218,13 @@ namespace ConverterLib
 		}
 
 		// for each vertex...
-		for (size_t i = 0; i < weights.m_Weights.Size(); ++i)
+		for (size_t i = 0; i < numWeights; ++i)
 		{
 			// each vertex consist of 4 weights (for 4 bones)
-			for (int j = 0; j < weights.m_Weights[i].NUM_OF_WEIGHTS; ++j)
+			for (int j = 0; j < weights[i].NUM_OF_WEIGHTS; ++j)
 			{
-				BoneWeight& weight = weights.m_Weights[i].m_BoneWeights[j];
-				uint32_t& ei = weight.m_EnvelopeIndex;
+				const BoneWeight& weight = weights[i].m_BoneWeights[j];
+				const uint32_t ei = weight.m_EnvelopeIndex;
 
 				// Do not process if the weight is 0.0 anyway
 				if (weight.m_WeightValue == 0.0f)
@@ -653,7 +1242,7 @@ namespace ConverterLib
 						// won't yield any results. So we have to find the Bone via CRC
 						MODL& bone = Mesh->m_MeshBlock.m_Models[envelope.m_ModelIndices[ei]];
 
-						CRCChecksum crc = CRC::CalcLowerCRC(bone.m_Name.m_Text.Buffer());
+						CRCChecksum crc = ModelCRCs[envelope.m_ModelIndices[ei]];
 						FbxNode* BoneNode = FindNode(crc);
 
 						if (BoneNode == nullptr)
@@ -662,146 +1251,707 @@ namespace ConverterLib
 							continue;
 						}
 
-						// In MSH the end point represents the Bone, while in FBX the start point represents the bone.
-						// This leads to inconsistent application of weights. 
-						// To prevent that, we have to map the weights onto the Nodes parent
+						// In MSH the end point represents the Bone, while in FBX the start point represents the bone.
+						// This leads to inconsistent application of weights. 
+						// To prevent that, we have to map the weights onto the Nodes parent
+
+						// Example layout: root_r_upperarm --> bone_r_upperarm --> bone_r_forearm --> eff_r_forearm
+						// In MSH, weights for upperarm and forearm are applied to: bone_r_forearm and eff_r_forearm
+						// But in FBX, we want to apply them to: bone_r_upperarm and bone_r_forearm
+						BoneNode = BoneNode->GetParent();
+
+						if (BoneNode != nullptr)
+						{
+							FbxCluster* cluster = nullptr;
+
+							auto it2 = BoneToCluster.find(&bone);
+							if (it2 != BoneToCluster.end())
+							{
+								cluster = it2->second;
+							}
+							else
+							{
+								cluster = FbxCluster::Create(Scene, (string(bone.m_Name.m_Text.Buffer()) + "_Cluster").c_str());
+								cluster->SetLinkMode(FbxCluster::eTotalOne);
+								cluster->SetLink(BoneNode);
+								BoneToCluster[&bone] = cluster;
+							}
+
+							// TODO: do all 4 weights really add up to 1.0 in MSH? investigation needed!
+							cluster->AddControlPointIndex((int)(i + vertexOffset), (double)weight.m_WeightValue);
+							cluster->SetTransformMatrix(matrixMeshNode);
+
+							// bone node transform matrix
+							cluster->SetTransformLinkMatrix(GetGlobalTransform(BoneNode));
+						}
+						else
+						{
+							Log("MODL (Bone) '" + string(bone.m_Parent.m_Text.Buffer()) + "' has been mapped to NULL!", ELogType::Warning);
+						}
+					}
+					else
+					{
+						Log("Model Index " + std::to_string(envelope.m_ModelIndices[ei]) + " is out of Range " + std::to_string(Mesh->m_MeshBlock.m_Models.Size()), ELogType::Warning);
+					}
+				}
+				else
+				{
+					Log("Envelope Index " + std::to_string(weight.m_EnvelopeIndex) + " is out of Range " + std::to_string(envelope.m_ModelIndices.Size()), ELogType::Warning);
+				}
+			}
+		}
+	}
+
+	void Converter::KeysToFBXCurve(FbxAnimCurve* curve, const vector<FbxTime>& times, const vector<float>& values)
+	{
+		// Allocate all keys at once and set them in order,
+		// instead of growing and searching the curve per key
+		curve->KeyModifyBegin();
+		curve->ResizeKeyBuffer((int)times.size());
+		for (size_t i = 0; i < times.size(); ++i)
+		{
+			curve->KeySet((int)i, times[i], values[i], FbxAnimCurveDef::eInterpolationLinear);
+		}
+		curve->KeyModifyEnd();
+	}
+
+	FbxAnimCurve* Converter::FindSharedCurve(const size_t hash, const vector<FbxTime>& times, const vector<float>& values)
+	{
+		auto it = CurveCache.find(hash);
+		if (it == CurveCache.end())
+		{
+			return nullptr;
+		}
+
+		// compare keys, in case of hash collisions
+		for (FbxAnimCurve* curve : it->second)
+		{
+			if (curve->KeyGetCount() != (int)times.size())
+			{
+				continue;
+			}
+
+			bool equal = true;
+			for (int i = 0; equal && i < (int)times.size(); ++i)
+			{
+				equal = curve->KeyGetTime(i) == times[i] && curve->KeyGetValue(i) == values[i];
+			}
+
+			if (equal)
+			{
+				return curve;
+			}
+		}
+		return nullptr;
+	}
+
+	// Frame rates come straight from the file (or the user), so
+	// reject the ones no sensible frame length can be derived from
+	static bool TicksPerFrame(const float frameRate, FbxLongLong& ticksPerFrame)
+	{
+		if (!std::isfinite(frameRate) || frameRate <= 0.0f)
+		{
+			return false;
+		}
+
+		// at least one tick, and at most about a day per frame
+		const double ticks = FbxTime::GetOneSecond().Get() / (double)frameRate;
+		if (!(ticks >= 1.0 && ticks <= 4e15))
+		{
+			return false;
+		}
+
+		ticksPerFrame = std::llround(ticks);
+		return true;
+	}
+
+	void Converter::ANM2ToFBXAnimations(ANM2& animations)
+	{
+		if (animations.m_AnimationCycle.m_Animations.Size() == 0)
+		{
+			Log("No Animation Circle found!", ELogType::Warning);
+			return;
+		}
+
+		if (MinBoneCoverage > 0.0f && !CheckBoneCoverage(animations))
+		{
+			return;
+		}
+
+		// Optional resampling onto a uniform grid of ResampleFrameRate. Translations
+		// are interpolated linearly, rotations via slerp on the (aligned) quaternions
+		const bool bResample = ResampleFrameRate != 0.0f;
+		FbxLongLong resampleTicksPerFrame = 0;
+		if (bResample && !TicksPerFrame(ResampleFrameRate, resampleTicksPerFrame))
+		{
+			Log("Cannot resample to an invalid frame rate of " + std::to_string(ResampleFrameRate) + "!", ELogType::Error);
+			return;
+		}
+
+		// One Stack per animation cycle. All cycles share the same keyframe
+		// data (KFR3), each one covering its own range of frames
+		struct Cycle
+		{
+			string Name;
+			FbxAnimLayer* Layer;
+			float FrameRate;
+			FbxLongLong TicksPerFrame;
+			uint32_t FirstFrame;
+			uint32_t LastFrame;
+			size_t NumKeys;
+			size_t NumReducedKeys;
+		};
+
+		const size_t numFileCycles = animations.m_AnimationCycle.m_Animations.Size();
+		vector<Cycle> cycles;
+		cycles.reserve(numFileCycles);
+
+		for (size_t i = 0; i < numFileCycles; ++i)
+		{
+			Animation& anim = animations.m_AnimationCycle.m_Animations[i];
+
+			string animName = anim.m_AnimationName.Buffer();
+			if (OverrideAnimName != "")
+			{
+				animName = numFileCycles > 1 ? OverrideAnimName + "_" + animName : OverrideAnimName;
+			}
+
+			// All key times are whole frames, so compute the length of one
+			// frame once and derive every key time by integer multiplication
+			FbxLongLong ticksPerFrame;
+			if (!TicksPerFrame(anim.m_FrameRate, ticksPerFrame))
+			{
+				Log("Skipping Animation '" + animName + "', its frame rate " + std::to_string(anim.m_FrameRate) + " is invalid!", ELogType::Error);
+				continue;
+			}
+
+			FbxAnimStack* animStack = FbxAnimStack::Create(Scene, animName.c_str());
+
+			FbxTime start(anim.m_FirstFrame * ticksPerFrame);
+			FbxTime end(anim.m_LastFrame * ticksPerFrame);
+
+			FbxTimeSpan timeSpan(start,end);
+
+			animStack->SetLocalTimeSpan(timeSpan);//FbxTimeSpan(start, end));
+
+			FbxAnimLayer* animLayer = FbxAnimLayer::Create(Scene, string(animName + "_Layer").c_str());
+			animStack->AddMember(animLayer);
+
+			// remember the source file, for incremental updates (see UpdateMSH)
+			if (CurrentSourceInfo.Hash != "")
+			{
+				SetStackProperty(animStack, StackSourceProperty, CurrentSource);
+				SetStackProperty(animStack, StackHashProperty, CurrentSourceInfo.Hash);
+				SetStackProperty(animStack, StackSizeProperty, CurrentSourceInfo.Size);
+				SetStackProperty(animStack, StackTimeProperty, CurrentSourceInfo.Time);
+				SourceStacks[CurrentSource].push_back(animStack);
+			}
+
+			cycles.push_back({ animName, animLayer, anim.m_FrameRate, ticksPerFrame, anim.m_FirstFrame, anim.m_LastFrame, 0, 0 });
+		}
+
+		// cycles with an invalid frame rate have been skipped
+		const size_t numCycles = cycles.size();
+		if (numCycles == 0)
+		{
+			return;
+		}
+
+		if (bResample)
+		{
+			FbxGlobalSettings& settings = Scene->GetGlobalSettings();
+			const FbxTime::EMode timeMode = FbxTime::ConvertFrameRateToTimeMode(ResampleFrameRate);
+			settings.SetTimeMode(timeMode);
+			if (timeMode == FbxTime::eCustom)
+			{
+				settings.SetCustomFrameRate(ResampleFrameRate);
+			}
+		}
+
+		// Keys of one channel of one cycle, ready to be committed to a curve
+		struct ChannelKeys
+		{
+			vector<FbxTime> Times;
+			vector<float> Values;
+			size_t NumKeys;		// before keyframe reduction
+			size_t Hash;		// see bShareCurves
+		};
+
+		// Per cycle three translation channels, followed by three rotation channels
+		struct BoneKeys
+		{
+			BoneFrames* Frames;
+			FbxNode* Node;
+			vector<std::array<ChannelKeys, 6>> Cycles;
+		};
+
+		// Look up all bones first, the Scene must not be touched while generating keys
+		List<BoneFrames>& boneFrames = animations.m_KeyFrames.m_BoneFrames;
+		vector<BoneKeys> bones;
+		bones.reserve(boneFrames.Size());
+		for (size_t i = 0; i < boneFrames.Size(); ++i)
+		{
+			FbxNode* boneNode = FindNode(boneFrames[i].m_CRCchecksum);
+			if (boneNode == nullptr)
+			{
+				Log("Could not find a Bone for CRC: " + std::to_string(boneFrames[i].m_CRCchecksum), ELogType::Warning);
+				continue;
+			}
+			bones.push_back({ &boneFrames[i], boneNode, vector<std::array<ChannelKeys, 6>>(numCycles) });
+		}
+
+		// Scratch memory of one worker, reused for all bones it processes.
+		// Each bones keyframes are read and converted once (track),
+		// then split into the cycles by frame range (Times/Values)
+		struct Scratch
+		{
+			vector<uint32_t> TrackFrames;
+			vector<float> TrackValues[3];
+			vector<Vector4> Rotations;
+			vector<uint32_t> SampleKeys;
+			vector<float> SampleWeights;
+			vector<Vector4> SampledRotations;
+			vector<FbxTime> Times;
+			vector<float> Values[3];
+		};
+
+		auto resampleSlice = [&](Scratch& s, const Cycle& cycle, const size_t offset, const size_t count, const bool bRotation)
+		{
+			// whole target frames covered by the keys of the slice
+			const double ratio = ResampleFrameRate / cycle.FrameRate;
+			int64_t firstSample = 0;
+			size_t numSamples = 0;
+			if (count > 1)
+			{
+				firstSample = (int64_t)std::ceil(s.TrackFrames[offset] * ratio - 1e-6);
+				const int64_t lastSample = (int64_t)std::floor(s.TrackFrames[offset + count - 1] * ratio + 1e-6);
+				numSamples = lastSample >= firstSample ? (size_t)(lastSample - firstSample + 1) : 0;
+			}
+
+			if (numSamples == 0)
+			{
+				// nothing to interpolate in between, keep the keys as they are
+				s.Times.resize(count);
+				for (size_t j = 0; j < count; ++j)
+				{
+					s.Times[j] = FbxTime(s.TrackFrames[offset + j] * cycle.TicksPerFrame);
+				}
+				for (size_t k = 0; k < 3; ++k)
+				{
+					s.Values[k].assign(s.TrackValues[k].begin() + offset, s.TrackValues[k].begin() + offset + count);
+				}
+				if (bRotation)
+				{
+					AnimationKernels::QuaternionsToEuler(s.Rotations.data() + offset, count, s.Values[0].data(), s.Values[1].data(), s.Values[2].data());
+				}
+				return;
+			}
+
+			s.SampleKeys.resize(numSamples);
+			s.SampleWeights.resize(numSamples);
+			AnimationKernels::ComputeSamplePositions(s.TrackFrames.data() + offset, count, firstSample / ratio, 1.0 / ratio, numSamples, s.SampleKeys.data(), s.SampleWeights.data());
+
+			s.Times.resize(numSamples);
+			for (size_t j = 0; j < numSamples; ++j)
+			{
+				s.Times[j] = FbxTime((firstSample + (int64_t)j) * resampleTicksPerFrame);
+			}
+			for (size_t k = 0; k < 3; ++k)
+			{
+				s.Values[k].resize(numSamples);
+			}
+
+			if (bRotation)
+			{
+				s.SampledRotations.resize(numSamples);
+				AnimationKernels::SlerpKeys(s.Rotations.data() + offset, s.SampleKeys.data(), s.SampleWeights.data(), numSamples, s.SampledRotations.data());
+				AnimationKernels::QuaternionsToEuler(s.SampledRotations.data(), numSamples, s.Values[0].data(), s.Values[1].data(), s.Values[2].data());
+			}
+			else
+			{
+				for (size_t k = 0; k < 3; ++k)
+				{
+					AnimationKernels::LerpKeys(s.TrackValues[k].data() + offset, s.SampleKeys.data(), s.SampleWeights.data(), numSamples, s.Values[k].data());
+				}
+			}
+		};
+
+		// Cut the keys of a cycle out of the current track. With just one
+		// cycle, all keys are taken regardless of the cycles frame range
+		auto sliceTrack = [&](Scratch& s, const Cycle& cycle, const bool bRotation)
+		{
+			auto first = s.TrackFrames.begin();
+			auto last = s.TrackFrames.end();
+			if (numFileCycles > 1)
+			{
+				first = std::lower_bound(s.TrackFrames.begin(), s.TrackFrames.end(), cycle.FirstFrame);
+				last = std::upper_bound(first, s.TrackFrames.end(), cycle.LastFrame);
+			}
+
+			const size_t offset = first - s.TrackFrames.begin();
+			const size_t count = last - first;
+
+			if (bResample)
+			{
+				resampleSlice(s, cycle, offset, count, bRotation);
+				return;
+			}
+
+			s.Times.resize(count);
+			for (size_t k = 0; k < 3; ++k)
+			{
+				s.Values[k].assign(s.TrackValues[k].begin() + offset, s.TrackValues[k].begin() + offset + count);
+			}
+			for (size_t j = 0; j < count; ++j)
+			{
+				s.Times[j] = FbxTime(s.TrackFrames[offset + j] * cycle.TicksPerFrame);
+			}
+		};
+
+		// Optional keyframe reduction, keeping track of the key counts for the report
+		auto finishChannel = [&](Scratch& s, const unsigned int channel, const float tolerance, ChannelKeys& keys)
+		{
+			keys.NumKeys = s.Values[channel].size();
+			if (bReduceKeyframes)
+			{
+				AnimationKernels::ReduceKeys(s.Times, s.Values[channel], tolerance, keys.Times, keys.Values);
+			}
+			else
+			{
+				keys.Times = s.Times;
+				keys.Values = s.Values[channel];
+			}
+			keys.Hash = bShareCurves ? AnimationKernels::HashKeys(keys.Times, keys.Values) : 0;
+		};
+
+		auto generateKeys = [&](Scratch& s, BoneKeys& bone)
+		{
+			// Translation
+			const size_t numTranslations = bone.Frames->m_TranslationFrames.Size();
+			s.TrackFrames.resize(numTranslations);
+			s.TrackValues[0].resize(numTranslations);
+			s.TrackValues[1].resize(numTranslations);
+			s.TrackValues[2].resize(numTranslations);
+			for (size_t j = 0; j < numTranslations; ++j)
+			{
+				TranslationFrame& tranFrame = bone.Frames->m_TranslationFrames[j];
+
+				s.TrackFrames[j] = tranFrame.m_FrameIndex;
+				s.TrackValues[0][j] = tranFrame.m_Translation.m_X;
+				s.TrackValues[1][j] = tranFrame.m_Translation.m_Y;
+				s.TrackValues[2][j] = tranFrame.m_Translation.m_Z;
+			}
+
+			for (size_t c = 0; c < numCycles; ++c)
+			{
+				sliceTrack(s, cycles[c], false);
+				for (unsigned int channel = 0; channel < 3; ++channel)
+				{
+					finishChannel(s, channel, PositionTolerance, bone.Cycles[c][channel]);
+				}
+			}
+
+			// Rotation
+			const size_t numRotations = bone.Frames->m_RotationFrames.Size();
+			s.TrackFrames.resize(numRotations);
+			s.TrackValues[0].resize(numRotations);
+			s.TrackValues[1].resize(numRotations);
+			s.TrackValues[2].resize(numRotations);
+			s.Rotations.resize(numRotations);
+			for (size_t j = 0; j < numRotations; ++j)
+			{
+				RotationFrame& rotFrame = bone.Frames->m_RotationFrames[j];
+
+				s.TrackFrames[j] = rotFrame.m_FrameIndex;
+				s.Rotations[j] = rotFrame.m_Rotation;
+			}
+
+			// convert all keys at once, unwrapping the angles across keys.
+			// When resampling, just the resampled keys are converted
+			AnimationKernels::AlignQuaternions(s.Rotations.data(), s.Rotations.data(), numRotations);
+			if (!bResample)
+			{
+				AnimationKernels::QuaternionsToEuler(s.Rotations.data(), numRotations, s.TrackValues[0].data(), s.TrackValues[1].data(), s.TrackValues[2].data());
+			}
+
+			for (size_t c = 0; c < numCycles; ++c)
+			{
+				sliceTrack(s, cycles[c], true);
+				for (unsigned int channel = 0; channel < 3; ++channel)
+				{
+					finishChannel(s, channel, RotationTolerance, bone.Cycles[c][3 + channel]);
+				}
+			}
+		};
 
-						// Example layout: root_r_upperarm --> bone_r_upperarm --> bone_r_forearm --> eff_r_forearm
-						// In MSH, weights for upperarm and forearm are applied to: bone_r_forearm and eff_r_forearm
-						// But in FBX, we want to apply them to: bone_r_upperarm and bone_r_forearm
-						BoneNode = BoneNode->GetParent();
+		// Bones are independent of each other, so generate all keys in parallel
+		Workers->ParallelFor(bones.size(), [&](const size_t begin, const size_t end)
+		{
+			Scratch scratch;
+			for (size_t i = begin; i < end; ++i)
+			{
+				generateKeys(scratch, bones[i]);
+			}
+		});
 
-						if (BoneNode != nullptr)
-						{
-							FbxCluster* cluster = nullptr;
+		// Committing to the curves has to happen on this thread
+		size_t numSharedCurves = 0;
+		const char* components[3] = { FBXSDK_CURVENODE_COMPONENT_X, FBXSDK_CURVENODE_COMPONENT_Y, FBXSDK_CURVENODE_COMPONENT_Z };
+		auto commitChannel = [&](Cycle& cycle, FbxPropertyT<FbxDouble3>& property, const unsigned int channel, const ChannelKeys& keys)
+		{
+			cycle.NumKeys += keys.NumKeys;
+			cycle.NumReducedKeys += keys.Values.size();
 
-							auto it2 = BoneToCluster.find(&bone);
-							if (it2 != BoneToCluster.end())
-							{
-								cluster = it2->second;
-							}
-							else
-							{
-								cluster = FbxCluster::Create(Scene, (string(bone.m_Name.m_Text.Buffer()) + "_Cluster").c_str());
-								cluster->SetLinkMode(FbxCluster::eTotalOne);
-								cluster->SetLink(BoneNode);
-								BoneToCluster[&bone] = cluster;
-							}
+			if (!bShareCurves)
+			{
+				KeysToFBXCurve(property.GetCurve(cycle.Layer, components[channel], true), keys.Times, keys.Values);
+				return;
+			}
 
-							// TODO: do all 4 weights really add up to 1.0 in MSH? investigation needed!
-							cluster->AddControlPointIndex((int)(i + vertexOffset), (double)weight.m_WeightValue);
-							cluster->SetTransformMatrix(matrixMeshNode);
+			// connect an already existing, identical curve if there is one
+			FbxAnimCurve* curve = FindSharedCurve(keys.Hash, keys.Times, keys.Values);
+			if (curve != nullptr)
+			{
+				++numSharedCurves;
+			}
+			else
+			{
+				curve = FbxAnimCurve::Create(Scene, "");
+				KeysToFBXCurve(curve, keys.Times, keys.Values);
+				CurveCache[keys.Hash].push_back(curve);
+			}
+			property.GetCurveNode(cycle.Layer, true)->ConnectToChannel(curve, channel);
+		};
 
-							// bone node transform matrix
-							FbxAMatrix& matrixBoneNode = BoneNode->EvaluateGlobalTransform();
-							cluster->SetTransformLinkMatrix(matrixBoneNode);
-						}
-						else
-						{
-							Log("MODL (Bone) '" + string(bone.m_Parent.m_Text.Buffer()) + "' has been mapped to NULL!", ELogType::Warning);
-						}
-					}
-					else
-					{
-						Log("Model Index " + std::to_string(envelope.m_ModelIndices[ei]) + " is out of Range " + std::to_string(Mesh->m_MeshBlock.m_Models.Size()), ELogType::Warning);
-					}
+		for (BoneKeys& bone : bones)
+		{
+			for (size_t c = 0; c < numCycles; ++c)
+			{
+				for (unsigned int channel = 0; channel < 3; ++channel)
+				{
+					commitChannel(cycles[c], bone.Node->LclTranslation, channel, bone.Cycles[c][channel]);
 				}
-				else
+			}
+			for (size_t c = 0; c < numCycles; ++c)
+			{
+				for (unsigned int channel = 0; channel < 3; ++channel)
 				{
-					Log("Envelope Index " + std::to_string(weight.m_EnvelopeIndex) + " is out of Range " + std::to_string(envelope.m_ModelIndices.Size()), ELogType::Warning);
+					commitChannel(cycles[c], bone.Node->LclRotation, channel, bone.Cycles[c][3 + channel]);
 				}
 			}
+
+			// the keys now live in the curves
+			bone.Cycles.clear();
+			bone.Cycles.shrink_to_fit();
+		}
+
+		if (bReduceKeyframes)
+		{
+			for (const Cycle& cycle : cycles)
+			{
+				Log("Keyframe reduction of '" + cycle.Name + "': " + std::to_string(cycle.NumKeys) + " -> " + std::to_string(cycle.NumReducedKeys) + " keys", ELogType::Info);
+			}
+		}
+
+		if (bShareCurves && numSharedCurves > 0)
+		{
+			Log("Reused " + std::to_string(numSharedCurves) + " identical animation curves", ELogType::Info);
 		}
 	}
 
-	void Converter::ANM2ToFBXAnimations(ANM2& animations)
+	bool Converter::CheckBoneCoverage(ANM2& animations)
 	{
-		if (animations.m_AnimationCycle.m_Animations.Size() == 0)
+		// map keys are in ascending order already
+		if (SkeletonBonesSize != CRCToFbxNode.size())
 		{
-			Log("No Animation Circle found!", ELogType::Warning);
-			return;
+			SkeletonBones.Clear();
+			for (auto it = CRCToFbxNode.begin(); it != CRCToFbxNode.end(); ++it)
+			{
+				SkeletonBones.Add(it->first);
+			}
+			SkeletonBones.Build();
+			SkeletonBonesSize = CRCToFbxNode.size();
 		}
 
-		// assuming only one animation per msh, this should be temporary
-		Animation& anim = animations.m_AnimationCycle.m_Animations[0];
-		string animName = OverrideAnimName != "" ? OverrideAnimName : anim.m_AnimationName.Buffer();
-		FbxAnimStack* animStack = FbxAnimStack::Create(Scene, animName.c_str());
+		BoneSet animBones;
+		List<BoneFrames>& boneFrames = animations.m_KeyFrames.m_BoneFrames;
+		for (size_t i = 0; i < boneFrames.Size(); ++i)
+		{
+			animBones.Add(boneFrames[i].m_CRCchecksum);
+		}
+		animBones.Build();
 
-		FbxTime start, end;
-		start.SetSecondDouble(anim.m_FirstFrame / anim.m_FrameRate);
-		end.SetSecondDouble(anim.m_LastFrame / anim.m_FrameRate);
+		const float coverage = animBones.CoverageIn(SkeletonBones);
+		if (coverage >= MinBoneCoverage)
+		{
+			return true;
+		}
 
-		FbxTimeSpan timeSpan(start,end);
+		string name = CurrentSource;
+		if (name == "")
+		{
+			name = animations.m_AnimationCycle.m_Animations[0].m_AnimationName.Buffer();
+		}
 
-		animStack->SetLocalTimeSpan(timeSpan);//FbxTimeSpan(start, end));
+		const string percent = std::to_string((int)std::floor(coverage * 100.0f)) + "%";
+		Log("Skipping Animation '" + name + "', just " + percent + " of its bones are in the Skeleton", ELogType::Warning);
+		SkippedAnimations.push_back(name + " (" + percent + " bone coverage)");
+		return false;
+	}
 
-		FbxAnimLayer* animLayer = FbxAnimLayer::Create(Scene, string(animName + "_Layer").c_str());
-		animStack->AddMember(animLayer);
+	bool Converter::MaterialKey::operator<(const MaterialKey& other) const
+	{
+		return std::tie(Name, Texture, Colors) < std::tie(other.Name, other.Texture, other.Colors);
+	}
 
-		// for every bone...
-		for (size_t i = 0; i < animations.m_KeyFrames.m_BoneFrames.Size(); ++i)
+	FbxSurfacePhong* Converter::MATDToFBXMaterial(const MATD& material)
+	{
+		if (Scene == nullptr)
 		{
-			BoneFrames& bf = animations.m_KeyFrames.m_BoneFrames[i];
-			FbxNode* boneNode = FindNode(bf.m_CRCchecksum);
+			Log("FbxScene is NULL!", ELogType::Error);
+			return nullptr;
+		}
 
-			if (boneNode == nullptr)
+		const Color& diffuse = material.m_Data.m_Diffuse;
+		const Color& ambient = material.m_Data.m_Ambient;
+		const Color& specular = material.m_Data.m_Specular;
+
+		MaterialKey key
+		{
+			material.m_Name.m_Text.Buffer(),
+			material.m_Texture0.m_Text.Buffer(),
 			{
-				Log("Could not find a Bone for CRC: " + std::to_string(bf.m_CRCchecksum), ELogType::Warning);
-				continue;
+				diffuse.m_Red, diffuse.m_Green, diffuse.m_Blue, diffuse.m_Alpha,
+				ambient.m_Red, ambient.m_Green, ambient.m_Blue, ambient.m_Alpha,
+				specular.m_Red, specular.m_Green, specular.m_Blue, specular.m_Alpha
 			}
+		};
 
-			// Translation
-			FbxAnimCurve* tranCurveX = boneNode->LclTranslation.GetCurve(animLayer, FBXSDK_CURVENODE_COMPONENT_X, true);
-			FbxAnimCurve* tranCurveY = boneNode->LclTranslation.GetCurve(animLayer, FBXSDK_CURVENODE_COMPONENT_Y, true);
-			FbxAnimCurve* tranCurveZ = boneNode->LclTranslation.GetCurve(animLayer, FBXSDK_CURVENODE_COMPONENT_Z, true);
+		auto it = MaterialCache.find(key);
+		if (it != MaterialCache.end())
+		{
+			return it->second;
+		}
 
-			tranCurveX->KeyModifyBegin();
-			tranCurveY->KeyModifyBegin();
-			tranCurveZ->KeyModifyBegin();
-			for (size_t j = 0; j < bf.m_TranslationFrames.Size(); ++j)
-			{
-				TranslationFrame& tranFrame = bf.m_TranslationFrames[j];
+		// Create Material if non existent
+		FbxSurfacePhong* fbxMaterial = FbxSurfacePhong::Create(Scene, key.Name.c_str());
+		fbxMaterial->Diffuse.Set(ColorToFBXColor(diffuse));
+		fbxMaterial->Ambient.Set(ColorToFBXColor(ambient));
+		fbxMaterial->Specular.Set(ColorToFBXColor(specular));
+
+		// Textures are shared between Materials too
+		FbxFileTexture* fbxTexture = nullptr;
+		auto texIt = TextureCache.find(key.Texture);
+		if (texIt != TextureCache.end())
+		{
+			fbxTexture = texIt->second;
+		}
+		else
+		{
+			fbxTexture = FbxFileTexture::Create(Scene, key.Texture.c_str());
+			fbxTexture->SetFileName(key.Texture.c_str()); // Resource file is in current directory.
+			fbxTexture->SetTextureUse(FbxTexture::eStandard);
+			fbxTexture->SetMappingType(FbxTexture::eUV);
+			fbxTexture->SetMaterialUse(FbxFileTexture::eModelMaterial);
+			TextureCache[key.Texture] = fbxTexture;
+		}
+
+		fbxMaterial->Diffuse.ConnectSrcObject(fbxTexture);
+
+		MaterialCache[key] = fbxMaterial;
+		return fbxMaterial;
+	}
+
+	bool Converter::PrepareMesh(MODL& model, const vector<SegmentGeometry>& segments, PreparedMesh& prepared)
+	{
+		// First pass: validate Segments and gather the overall sizes,
+		// so all arrays can be allocated once up front
+		size_t numVertices = 0;
+		size_t numStripIndices = 0;
+		bool hasUVs = false;
+		for (size_t i = 0; i < segments.size(); ++i)
+		{
+			const SegmentGeometry& segment = segments[i];
 
-				FbxTime time;
-				time.SetSecondDouble(tranFrame.m_FrameIndex / anim.m_FrameRate);
-				tranCurveX->KeySet(tranCurveX->KeyAdd(time), time, tranFrame.m_Translation.m_X, FbxAnimCurveDef::eInterpolationLinear);
-				tranCurveY->KeySet(tranCurveY->KeyAdd(time), time, tranFrame.m_Translation.m_Y, FbxAnimCurveDef::eInterpolationLinear);
-				tranCurveZ->KeySet(tranCurveZ->KeyAdd(time), time, tranFrame.m_Translation.m_Z, FbxAnimCurveDef::eInterpolationLinear);
+			if (segment.NumVertices != segment.NumNormals)
+			{
+				prepared.InvalidSegment = (int)i;
+				return false;
 			}
-			tranCurveX->KeyModifyEnd();
-			tranCurveY->KeyModifyEnd();
-			tranCurveZ->KeyModifyEnd();
 
-			// Rotation
-			FbxAnimCurve* rotCurveX = boneNode->LclRotation.GetCurve(animLayer, FBXSDK_CURVENODE_COMPONENT_X, true);
-			FbxAnimCurve* rotCurveY = boneNode->LclRotation.GetCurve(animLayer, FBXSDK_CURVENODE_COMPONENT_Y, true);
-			FbxAnimCurve* rotCurveZ = boneNode->LclRotation.GetCurve(animLayer, FBXSDK_CURVENODE_COMPONENT_Z, true);
+			numVertices += segment.NumVertices;
+			numStripIndices += segment.NumStripIndices;
+			hasUVs |= segment.NumUVs > 0;
+		}
+
+		prepared.Vertices.resize(numVertices);
+		prepared.Normals.resize(numVertices);
+		prepared.UVs.resize(hasUVs ? numVertices : 0);
+
+		// a strip of n indices yields at most n - 2 triangles
+		prepared.Triangles.reserve(numStripIndices * 3);
+		prepared.SegmentMaterials.reserve(segments.size());
 
-			rotCurveX->KeyModifyBegin();
-			rotCurveY->KeyModifyBegin();
-			rotCurveZ->KeyModifyBegin();
-			for (size_t j = 0; j < bf.m_RotationFrames.Size(); ++j)
+		// crawl all Segments, specialized on whether there are UVs to copy
+		auto crawlSegments = [&](auto uvLayout)
+		{
+			constexpr bool bUVs = decltype(uvLayout)::value;
+
+			size_t vertexOffset = 0;
+			for (size_t i = 0; i < segments.size(); ++i)
 			{
-				RotationFrame& rotFrame = bf.m_RotationFrames[j];
-				FbxVector4 rot(QuaternionToEuler(rotFrame.m_Rotation));
+				const SegmentGeometry& segment = segments[i];
+				const size_t segmentVertices = segment.NumVertices;
+
+				if (segmentVertices > 0)
+				{
+					GeometryKernels::WidenVectors(segment.Vertices, prepared.Vertices.data() + vertexOffset, segmentVertices);
+					GeometryKernels::WidenVectors(segment.Normals, prepared.Normals.data() + vertexOffset, segmentVertices);
+				}
+
+				// UVs are optional
+				if constexpr (bUVs)
+				{
+					const size_t segmentUVs = std::min(segment.NumUVs, segmentVertices);
+					if (segmentUVs > 0)
+					{
+						GeometryKernels::WidenVectors(segment.UVs, prepared.UVs.data() + vertexOffset, segmentUVs);
+					}
+					std::fill(prepared.UVs.begin() + vertexOffset + segmentUVs, prepared.UVs.begin() + vertexOffset + segmentVertices, FbxVector2(0.0, 0.0));
+				}
+
+				// convert MSH triangle strips to triangles
+				size_t numTriangles = 0;
+				if (segment.NumStripIndices > 0 && segmentVertices > 0)
+				{
+					numTriangles = GeometryKernels::DecodeTriangleStrips(segment.Strips, segment.NumStripIndices, segment.Vertices, segmentVertices, (int32_t)vertexOffset, prepared.Triangles);
+				}
+				prepared.SegmentMaterials.emplace_back(model.m_Geometry.m_Segments[i].m_MaterialIndex.m_MaterialIndex, numTriangles);
 
-				FbxTime time;
-				time.SetSecondDouble(rotFrame.m_FrameIndex / anim.m_FrameRate);
-				rotCurveX->KeySet(rotCurveX->KeyAdd(time), time, (float)rot[0], FbxAnimCurveDef::eInterpolationLinear);
-				rotCurveY->KeySet(rotCurveY->KeyAdd(time), time, (float)rot[1], FbxAnimCurveDef::eInterpolationLinear);
-				rotCurveZ->KeySet(rotCurveZ->KeyAdd(time), time, (float)rot[2], FbxAnimCurveDef::eInterpolationLinear);
+				// since in MSH vertices are local in their respective segments,
+				// we have to store an offset because in FBX vertices are global
+				vertexOffset += segmentVertices;
 			}
-			rotCurveX->KeyModifyEnd();
-			rotCurveY->KeyModifyEnd();
-			rotCurveZ->KeyModifyEnd();
+		};
+
+		if (hasUVs)
+		{
+			crawlSegments(std::true_type());
+		}
+		else
+		{
+			crawlSegments(std::false_type());
 		}
+
+		return true;
 	}
 
-	bool Converter::MATDToFBXMaterial(const MATD& material, FbxNode* meshNode, int& matIndex)
+	template<bool bMaterials>
+	bool Converter::MODLToFBXMesh(MODL& model, const PreparedMesh& prepared, MATL& materials, FbxNode* meshNode)
 	{
-		if (Manager == nullptr)
+		if (Scene == nullptr)
 		{
-			Log("FbxManager is NULL!", ELogType::Error);
+			Log("FbxScene is NULL!", ELogType::Error);
 			return false;
 		}
 
@@ -811,35 +1961,58 @@ namespace ConverterLib
 			return false;
 		}
 
-		matIndex = meshNode->GetMaterialIndex(material.m_Name.m_Text.Buffer());
-
-		// Create Material if non existent
-		if (matIndex < 0)
+		if (prepared.InvalidSegment >= 0)
 		{
-			FbxSurfacePhong* fbxMaterial = FbxSurfacePhong::Create(Scene, material.m_Name.m_Text.Buffer());
-			fbxMaterial->Diffuse.Set(ColorToFBXColor(material.m_Data.m_Diffuse));
-			fbxMaterial->Ambient.Set(ColorToFBXColor(material.m_Data.m_Ambient));
-			fbxMaterial->Specular.Set(ColorToFBXColor(material.m_Data.m_Specular));
+			Log("Inconsistent lengths of vertices and normals in Segment No: " + std::to_string(prepared.InvalidSegment), ELogType::Warning);
+			return false;
+		}
 
-			FbxFileTexture* fbxTexture = FbxFileTexture::Create(Scene, material.m_Texture0.m_Text.Buffer());
-			fbxTexture->SetFileName(material.m_Texture0.m_Text.Buffer()); // Resource file is in current directory.
-			fbxTexture->SetTextureUse(FbxTexture::eStandard);
-			fbxTexture->SetMappingType(FbxTexture::eUV);
-			fbxTexture->SetMaterialUse(FbxFileTexture::eModelMaterial);
+		FbxMesh* mesh = FbxMesh::Create(Scene, model.m_Name.m_Text.Buffer());
+		const int numVertices = (int)prepared.Vertices.size();
 
-			fbxMaterial->Diffuse.ConnectSrcObject(fbxTexture);
+		// Vertices (control points)
+		mesh->InitControlPoints(numVertices);
+		std::copy(prepared.Vertices.begin(), prepared.Vertices.end(), mesh->GetControlPoints());
 
-			matIndex = meshNode->AddMaterial(fbxMaterial);
+		// Normals
+		auto elementNormal = mesh->CreateElementNormal();
+		elementNormal->SetMappingMode(FbxGeometryElement::eByControlPoint);
+		elementNormal->SetReferenceMode(FbxGeometryElement::eDirect);
+		elementNormal->GetDirectArray().Resize(numVertices);
+		FbxVector4* normals = elementNormal->GetDirectArray().GetLocked(FbxLayerElementArray::eWriteLock);
+		std::copy(prepared.Normals.begin(), prepared.Normals.end(), normals);
+		elementNormal->GetDirectArray().Release(&normals);
+
+		// UVs (if any)
+		if (prepared.UVs.size() > 0)
+		{
+			FbxGeometryElementUV* elementUV = mesh->CreateElementUV("DiffuseUVs");
+			elementUV->SetMappingMode(FbxGeometryElement::eByControlPoint);
+			elementUV->SetReferenceMode(FbxGeometryElement::eDirect);
+			elementUV->GetDirectArray().Resize(numVertices);
+			FbxVector2* uvs = elementUV->GetDirectArray().GetLocked(FbxLayerElementArray::eWriteLock);
+			std::copy(prepared.UVs.begin(), prepared.UVs.end(), uvs);
+			elementUV->GetDirectArray().Release(&uvs);
 		}
 
+		// Emit all polygons at once, with the polygon arrays allocated up front.
+		// Materials are not set per polygon, but as one array afterwards
+		mesh->ReservePolygonCount((int)prepared.Triangles.size() / 3);
+		mesh->ReservePolygonVertexCount((int)prepared.Triangles.size());
+		AppendTriangles(mesh, prepared.Triangles);
+
+		SegmentMaterialsToFBX<bMaterials>(mesh, prepared.SegmentMaterials, materials, meshNode);
+
+		meshNode->SetNodeAttribute(mesh);
 		return true;
 	}
 
-	bool Converter::MODLToFBXMesh(MODL& model, MATL& materials, FbxNode* meshNode)
+	template<bool bMaterials>
+	bool Converter::MODLToFBXMeshStreamed(MODL& model, const vector<SegmentGeometry>& segments, MATL& materials, FbxNode* meshNode)
 	{
-		if (Manager == nullptr)
+		if (Scene == nullptr)
 		{
-			Log("FbxManager is NULL!", ELogType::Error);
+			Log("FbxScene is NULL!", ELogType::Error);
 			return false;
 		}
 
@@ -849,121 +2022,242 @@ namespace ConverterLib
 			return false;
 		}
 
-		FbxMesh* mesh = FbxMesh::Create(Manager, model.m_Name.m_Text.Buffer());
+		// First pass: validate Segments and gather the overall sizes,
+		// so the FBX arrays can be allocated once up front
+		size_t numVertices = 0;
+		size_t numStripIndices = 0;
+		bool hasUVs = false;
+		for (size_t i = 0; i < segments.size(); ++i)
+		{
+			const SegmentGeometry& segment = segments[i];
+
+			if (segment.NumVertices != segment.NumNormals)
+			{
+				Log("Inconsistent lengths of vertices and normals in Segment No: " + std::to_string(i), ELogType::Warning);
+				return false;
+			}
+
+			numVertices += segment.NumVertices;
+			numStripIndices += segment.NumStripIndices;
+			hasUVs |= segment.NumUVs > 0;
+		}
 
-		vector<FbxVector4> vertices;
-		vector<FbxVector4> normals;
-		vector<FbxVector2> uvs;
-		size_t vertexOffset = 0;
+		FbxMesh* mesh = FbxMesh::Create(Scene, model.m_Name.m_Text.Buffer());
+		mesh->InitControlPoints((int)numVertices);
+		FbxVector4* controlPoints = mesh->GetControlPoints();
 
-		vector<FbxCluster*> boneClusters;
+		auto elementNormal = mesh->CreateElementNormal();
+		elementNormal->SetMappingMode(FbxGeometryElement::eByControlPoint);
+		elementNormal->SetReferenceMode(FbxGeometryElement::eDirect);
+		elementNormal->GetDirectArray().Resize((int)numVertices);
+		FbxVector4* normals = elementNormal->GetDirectArray().GetLocked(FbxLayerElementArray::eWriteLock);
 
-		// crawl all Segments
-		for (size_t i = 0; i < model.m_Geometry.m_Segments.Size(); ++i)
+		FbxGeometryElementUV* elementUV = nullptr;
+		FbxVector2* uvs = nullptr;
+		if (hasUVs)
 		{
-			SEGM& segment = model.m_Geometry.m_Segments[i];
+			elementUV = mesh->CreateElementUV("DiffuseUVs");
+			elementUV->SetMappingMode(FbxGeometryElement::eByControlPoint);
+			elementUV->SetReferenceMode(FbxGeometryElement::eDirect);
+			elementUV->GetDirectArray().Resize((int)numVertices);
+			uvs = elementUV->GetDirectArray().GetLocked(FbxLayerElementArray::eWriteLock);
+		}
+
+		// a strip of n indices yields at most n - 2 triangles
+		mesh->ReservePolygonCount((int)numStripIndices);
+		mesh->ReservePolygonVertexCount((int)numStripIndices * 3);
+
+		// Second pass: write each Segment straight into the FBX arrays.
+		// Only the triangles of the current Segment are held in between
+		vector<int32_t> triangles;
+		vector<std::pair<uint32_t, size_t>> segmentMaterials;
+		segmentMaterials.reserve(segments.size());
+
+		// crawl all Segments, specialized on whether there are UVs to copy
+		auto crawlSegments = [&](auto uvLayout)
+		{
+			constexpr bool bUVs = decltype(uvLayout)::value;
 
-			if (segment.m_VertexList.m_Vertices.Size() == segment.m_NormalList.m_Normals.Size())
+			size_t vertexOffset = 0;
+			for (size_t i = 0; i < segments.size(); ++i)
 			{
-				// grab the segments vertices, normals and UVs
-				for (size_t j = 0; j < segment.m_VertexList.m_Vertices.Size(); ++j)
-				{
-					Vector3& v = segment.m_VertexList.m_Vertices[j];
-					vertices.emplace_back(v.m_X, v.m_Y, v.m_Z);
+				const SegmentGeometry& segment = segments[i];
+				const size_t segmentVertices = segment.NumVertices;
 
-					Vector3& n = segment.m_NormalList.m_Normals[j];
-					normals.emplace_back(n.m_X, n.m_Y, n.m_Z);
+				if (segmentVertices > 0)
+				{
+					GeometryKernels::WidenVectors(segment.Vertices, controlPoints + vertexOffset, segmentVertices);
+					GeometryKernels::WidenVectors(segment.Normals, normals + vertexOffset, segmentVertices);
+				}
 
-					// UVs are optional
-					if (j < segment.m_UVList.m_UVs.Size())
+				if constexpr (bUVs)
+				{
+					const size_t segmentUVs = std::min(segment.NumUVs, segmentVertices);
+					if (segmentUVs > 0)
 					{
-						Vector2& uv = segment.m_UVList.m_UVs[j];
-						uvs.emplace_back(uv.m_X, uv.m_Y);
+						GeometryKernels::WidenVectors(segment.UVs, uvs + vertexOffset, segmentUVs);
 					}
+					std::fill(uvs + vertexOffset + segmentUVs, uvs + vertexOffset + segmentVertices, FbxVector2(0.0, 0.0));
 				}
 
-				// convert MSH triangle strips to polygons
-				segment.m_TriangleList.CalcPolygons();
-				for (size_t j = 0; j < segment.m_TriangleList.m_Polygons.Size(); ++j)
+				triangles.clear();
+				if (segment.NumStripIndices > 0 && segmentVertices > 0)
 				{
-					auto& poly = segment.m_TriangleList.m_Polygons[j];
+					GeometryKernels::DecodeTriangleStrips(segment.Strips, segment.NumStripIndices, segment.Vertices, segmentVertices, (int32_t)vertexOffset, triangles);
+				}
 
-					uint32_t& mshMatIndex = segment.m_MaterialIndex.m_MaterialIndex;
-					int fbxMatIndex = -1;
+				AppendTriangles(mesh, triangles);
+				segmentMaterials.emplace_back(model.m_Geometry.m_Segments[i].m_MaterialIndex.m_MaterialIndex, triangles.size() / 3);
 
-					if (mshMatIndex >= 0 && mshMatIndex < materials.m_Materials.Size())
-					{
-						MATD& mshMat = materials.m_Materials[segment.m_MaterialIndex.m_MaterialIndex];
+				vertexOffset += segmentVertices;
+			}
+		};
 
-						if ((ChunkFilter & EChunkFilter::Materials) == 0 && !MATDToFBXMaterial(mshMat, meshNode, fbxMatIndex))
-						{
-							Log("Could not convert MSH Material '" + string(mshMat.m_Name.m_Text.Buffer()) + "' to FbxMaterial!", ELogType::Warning);
-						}
-					}
-					else
+		if (hasUVs)
+		{
+			crawlSegments(std::true_type());
+		}
+		else
+		{
+			crawlSegments(std::false_type());
+		}
+
+		elementNormal->GetDirectArray().Release(&normals);
+		if (elementUV != nullptr)
+		{
+			elementUV->GetDirectArray().Release(&uvs);
+		}
+
+		SegmentMaterialsToFBX<bMaterials>(mesh, segmentMaterials, materials, meshNode);
+
+		meshNode->SetNodeAttribute(mesh);
+		return true;
+	}
+
+	// Writes the triangles straight into the meshes polygon arrays, just like
+	// BeginPolygon / AddPolygon / EndPolygon without material, texture or group
+	// would, but without four SDK calls per triangle
+	void Converter::AppendTriangles(FbxMesh* mesh, const vector<int32_t>& triangles)
+	{
+		const int numTriangles = (int)triangles.size() / 3;
+		const int firstPolygon = mesh->mPolygons.Size();
+		const int firstVertex = mesh->mPolygonVertices.Size();
+
+		mesh->mPolygonVertices.Resize(firstVertex + (int)triangles.size());
+		std::copy(triangles.begin(), triangles.end(), mesh->mPolygonVertices.GetArray() + firstVertex);
+
+		mesh->mPolygons.Resize(firstPolygon + numTriangles);
+		FbxMesh::PolygonDef* polygons = mesh->mPolygons.GetArray() + firstPolygon;
+		for (int i = 0; i < numTriangles; ++i)
+		{
+			polygons[i].mIndex = firstVertex + i * 3;
+			polygons[i].mSize = 3;
+			polygons[i].mGroup = -1;
+		}
+	}
+
+	template<bool bMaterials>
+	void Converter::SegmentMaterialsToFBX(FbxMesh* mesh, const vector<std::pair<uint32_t, size_t>>& segmentMaterials, MATL& materials, FbxNode* meshNode)
+	{
+		// The material is the same for a whole segment, so resolve it once per
+		// segment instead of per polygon. Shared Scene materials and their index on this node
+		vector<int> polygonMaterials;
+		polygonMaterials.reserve(mesh->GetPolygonCount());
+		map<FbxSurfacePhong*, int> nodeMaterials;
+		bool hasMaterials = false;
+
+		for (auto [mshMatIndex, numTriangles] : segmentMaterials)
+		{
+			int fbxMatIndex = -1;
+
+			if (mshMatIndex < materials.m_Materials.Size())
+			{
+				if constexpr (bMaterials)
+				{
+					MATD& mshMat = materials.m_Materials[mshMatIndex];
+					FbxSurfacePhong* fbxMaterial = MATDToFBXMaterial(mshMat);
+
+					if (fbxMaterial == nullptr)
 					{
-						Log("Material Index '" + std::to_string(mshMatIndex) + "' out of bounds " + std::to_string(materials.m_Materials.Size()), ELogType::Warning);
+						Log("Could not convert MSH Material '" + string(mshMat.m_Name.m_Text.Buffer()) + "' to FbxMaterial!", ELogType::Warning);
 					}
-
-					mesh->BeginPolygon(fbxMatIndex);
-					for (size_t k = 0; k < poly.m_VertexIndices.Size(); ++k)
+					else
 					{
-						mesh->AddPolygon((int)(poly.m_VertexIndices[k] + vertexOffset));
+						auto it = nodeMaterials.find(fbxMaterial);
+						if (it != nodeMaterials.end())
+						{
+							fbxMatIndex = it->second;
+						}
+						else
+						{
+							fbxMatIndex = meshNode->AddMaterial(fbxMaterial);
+							nodeMaterials[fbxMaterial] = fbxMatIndex;
+						}
 					}
-					mesh->EndPolygon();
 				}
-
-				// since in MSH vertices are local in their respective segments,
-				// we have to store an offset because in FBX vertices are global
-				vertexOffset += segment.m_VertexList.m_Vertices.Size();
 			}
 			else
 			{
-				Log("Inconsistent lengths of vertices and normals in Segment No: " + std::to_string(i), ELogType::Warning);
-				mesh->Destroy(true);
-				mesh = nullptr;
-				return false;
+				Log("Material Index '" + std::to_string(mshMatIndex) + "' out of bounds " + std::to_string(materials.m_Materials.Size()), ELogType::Warning);
 			}
+
+			polygonMaterials.insert(polygonMaterials.end(), numTriangles, fbxMatIndex);
+			hasMaterials |= fbxMatIndex >= 0 && numTriangles > 0;
 		}
 
-		// Set vertices (control points)
-		mesh->InitControlPoints((int)vertices.size());
-		FbxVector4* cps = mesh->GetControlPoints();
-		for (size_t i = 0; i < vertices.size(); ++i)
+		if (hasMaterials)
 		{
-			cps[i] = vertices[i];
+			FbxGeometryElementMaterial* elementMaterial = mesh->CreateElementMaterial();
+			elementMaterial->SetMappingMode(FbxGeometryElement::eByPolygon);
+			elementMaterial->SetReferenceMode(FbxGeometryElement::eIndexToDirect);
+
+			FbxLayerElementArrayTemplate<int>& indices = elementMaterial->GetIndexArray();
+			indices.Resize((int)polygonMaterials.size());
+			int* materialIndices = indices.GetLocked(FbxLayerElementArray::eWriteLock);
+			std::copy(polygonMaterials.begin(), polygonMaterials.end(), materialIndices);
+			indices.Release(&materialIndices);
 		}
+	}
 
-		// Set Normals
-		auto elementNormal = mesh->CreateElementNormal();
-		elementNormal->SetMappingMode(FbxGeometryElement::eByControlPoint);
-		elementNormal->SetReferenceMode(FbxGeometryElement::eDirect);
-		for (size_t i = 0; i < normals.size(); ++i)
+	vector<SegmentGeometry> Converter::GetSegmentGeometry(const size_t modelIndex)
+	{
+		if (!MappedGeometry.empty())
 		{
-			elementNormal->GetDirectArray().Add(normals[i]);
+			return MappedGeometry[modelIndex];
 		}
 
-		// Set UVs (if any)
-		if (uvs.size() > 0)
+		MODL& model = Mesh->m_MeshBlock.m_Models[modelIndex];
+		vector<SegmentGeometry> segments(model.m_Geometry.m_Segments.Size());
+		for (size_t i = 0; i < segments.size(); ++i)
 		{
-			auto elementUV = mesh->CreateElementUV("DiffuseUVs");
-			elementUV->SetMappingMode(FbxGeometryElement::eByControlPoint);
-			elementUV->SetReferenceMode(FbxGeometryElement::eDirect);
-			for (size_t i = 0; i < uvs.size(); ++i)
+			segments[i] = SegmentGeometry::FromSegment(model.m_Geometry.m_Segments[i]);
+		}
+		return segments;
+	}
+
+	void Converter::ReleaseGeometry(MODL& model, const bool bKeepSkinning)
+	{
+		for (size_t i = 0; i < model.m_Geometry.m_Segments.Size(); ++i)
+		{
+			SEGM& segment = model.m_Geometry.m_Segments[i];
+			segment.m_NormalList.m_Normals.Clear();
+			segment.m_UVList.m_UVs.Clear();
+			segment.m_TriangleList.m_Triangles.Clear();
+
+			// skinning walks the weights, and needs the vertex counts for their offsets
+			if (!bKeepSkinning)
 			{
-				elementUV->GetDirectArray().Add(uvs[i]);
+				segment.m_VertexList.m_Vertices.Clear();
+				segment.m_WeightList.m_Weights.Clear();
 			}
 		}
-
-		meshNode->SetNodeAttribute(mesh);
-		return true;
 	}
 
 	bool Converter::MODLToFBXSkeleton(MODL& model, FbxNode* boneNode)
 	{
-		if (Manager == nullptr)
+		if (Scene == nullptr)
 		{
-			Log("FbxManager is NULL!", ELogType::Error);
+			Log("FbxScene is NULL!", ELogType::Error);
 			return false;
 		}
 
@@ -974,7 +2268,7 @@ namespace ConverterLib
 		}
 
 		EModelPurpose purpose = model.GetPurpose();
-		FbxSkeleton* bone = FbxSkeleton::Create(Manager, model.m_Name.m_Text.Buffer());
+		FbxSkeleton* bone = FbxSkeleton::Create(Scene, model.m_Name.m_Text.Buffer());
 		bone->Size.Set(1.0f);
 
 		switch (purpose)
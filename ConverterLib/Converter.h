@@ -40,6 +40,48 @@ namespace ConverterLib
 		string OverrideAnimName = "";
 		bool bEmptyMeshes = false;
 		bool bPrintHierachy = false;
+
+		// Keyframe reduction. Drops keys that linear interpolation already
+		// reproduces within the given tolerances, collapses constant channels
+		bool bReduceKeyframes = false;
+		float PositionTolerance = 0.0001f;	// in position units
+		float RotationTolerance = 0.01f;	// in degrees
+
+		// Reuse identical animation curves across all Stacks of the Scene,
+		// instead of storing them again for every animation
+		bool bShareCurves = false;
+
+		// Animations whose bones are covered by the Skeleton at hand by less
+		// than this fraction (0.0 - 1.0) are skipped entirely. 0 disables the check.
+		// Skipped Animations are collected (with their coverage) in SkippedAnimations
+		float MinBoneCoverage = 0.0f;
+		vector<string> SkippedAnimations;
+
+		// Resample all Animations to keys on a uniform grid of this frame rate.
+		// 0 keeps the keys as they are
+		float ResampleFrameRate = 0.0f;
+
+		// Convert Meshes one by one, streaming their Segments straight into the
+		// FbxMesh, and free each models MSH geometry as soon as it's converted
+		// (only for MSHs read by AddMSH(path)). Lower peak memory, but no parallelism
+		bool bLowMemory = false;
+
+		// Decode only the chunks of an MSH file that ChunkFilter and ModelIgnoreFilter let
+		// through (see MSHScanner), e.g. just ANM2 for Animation only conversions, and no
+		// geometry of ignored Models. Vertices, normals, UVs and strips aren't decoded at all,
+		// but converted straight from the memory mapped file. Falls back to reading the whole
+		// file if it can't be scanned
+		bool bLazyParsing = true;
+
+		// Remember the source MSH file and a hash of its content in every Animation
+		// Stack added by AddMSH(path), so the FBX can be updated later (see UpdateMSH).
+		// Costs one more pass over each MSH file
+		bool bTagSources = false;
+
+		// Threads used for conversion work that doesn't touch the Scene.
+		// 0 uses one per CPU core, 1 converts everything on the calling thread.
+		// Takes effect on the next Start
+		uint32_t NumThreads = 0;
 		fs::path BaseposeMSH = "";
 
 		static void SetLogCallback(const LogCallback Callback);
@@ -47,6 +89,19 @@ namespace ConverterLib
 		bool AddMSH(const fs::path& mshFileName);
 		bool AddMSH(MSH* msh);
 		bool SaveFBX();
+		bool SaveFBX(const fs::path& fbxFileName);
+		void ClearAnimations();
+
+		// Incremental updates of merged Animation banks. Stacks added by UpdateMSH (or
+		// AddMSH with bTagSources) remember their MSH file, its size, modification time
+		// and a hash of its content. RemoveMissingSources removes the Stacks of MSH files
+		// that don't exist any more, RemoveAnimationsExcept those of all but the given ones
+		bool LoadFBX(const fs::path& fbxFileName);
+		bool UpdateMSH(const fs::path& mshFileName);
+		void RemoveAnimations(const fs::path& mshFileName);
+		void RemoveAnimationsExcept(const vector<fs::path>& mshFileNames);
+		void RemoveMissingSources();
+
 		bool ClearFBXScene();
 		void Close();
 
@@ -54,28 +109,113 @@ namespace ConverterLib
 		map<MODL*, FbxNode*> MODLToFbxNode;
 		map<CRCChecksum, FbxNode*> CRCToFbxNode;
 
+		// Materials and Textures are shared across all nodes of the Scene.
+		// MATDs are identified by content rather than pointer, since equal
+		// materials are usually duplicated across models and MSH files
+		struct MaterialKey
+		{
+			string Name;
+			string Texture;
+			std::array<float, 12> Colors;
+
+			bool operator<(const MaterialKey& other) const;
+		};
+		map<MaterialKey, FbxSurfacePhong*> MaterialCache;
+		map<string, FbxFileTexture*> TextureCache;
+
+		// Geometry of one MODL in plain memory, ready to be copied into an FbxMesh.
+		// Prepared on worker threads, since it doesn't touch the Scene
+		struct PreparedMesh
+		{
+			vector<FbxVector4> Vertices;
+			vector<FbxVector4> Normals;
+			vector<FbxVector2> UVs;				// empty if no Segment has UVs
+			vector<int32_t> Triangles;
+			vector<std::pair<uint32_t, size_t>> SegmentMaterials;	// MSH material index and triangle count per Segment
+			int InvalidSegment = -1;
+		};
+
+		// Animation curves by hash of their keys, see bShareCurves
+		map<size_t, vector<FbxAnimCurve*>> CurveCache;
+
+		// What a tagged Stack remembers about its source MSH file. Size and
+		// modification time are compared first, the hash only if they differ
+		struct SourceInfo
+		{
+			string Hash;
+			string Size;
+			string Time;
+		};
+
+		// Tagged Stacks by source (see SourceKey), for incremental updates
+		map<string, vector<FbxAnimStack*>> SourceStacks;
+
+		// CRCs of all nodes in the Scene, see MinBoneCoverage.
+		// Rebuilt whenever the number of nodes changed
+		BoneSet SkeletonBones;
+		size_t SkeletonBonesSize = 0;
+
 		FbxNode* FindNode(MODL* model);
 		FbxNode* FindNode(const CRCChecksum checksum);
 		FbxDouble3 ColorToFBXColor(const Color& color);
 		FbxDouble4 QuaternionToEuler(const Vector4& Quaternion);
 		void ApplyTransform(FbxNode* modelNode, const Vector3& Translation, const Vector4& Rotation);
 		void ApplyTransform(FbxNode* modelNode, const Vector3& Translation, const Vector4& Rotation, const Vector3& Scale);
+		const FbxAMatrix& GetGlobalTransform(FbxNode* node);
+		void MSHToFBXScene();
+		template<bool bEmpty, size_t... Filters>
+		void MSHToFBXScene(const uint8_t filter, std::index_sequence<Filters...>);
+		template<uint8_t Filter, bool bEmpty>
 		void MSHToFBXScene();
+		static void KeysToFBXCurve(FbxAnimCurve* curve, const vector<FbxTime>& times, const vector<float>& values);
+		FbxAnimCurve* FindSharedCurve(const size_t hash, const vector<FbxTime>& times, const vector<float>& values);
 		void ANM2ToFBXAnimations(ANM2& animations);
-		void WGHTToFBXSkin(WGHT& weights, const ENVL& envelope, const FbxAMatrix& matrixMeshNode, const size_t vertexOffset, map<MODL*, FbxCluster*>& BoneToCluster);
-		bool MATDToFBXMaterial(const MATD& material, FbxNode* meshNode, int& matIndex);
-		bool MODLToFBXMesh(MODL& model, MATL& materials, FbxNode* meshNode);
+		bool CheckBoneCoverage(ANM2& animations);
+		void WGHTToFBXSkin(const VertexWeights* weights, const size_t numWeights, const ENVL& envelope, const FbxAMatrix& matrixMeshNode, const size_t vertexOffset, map<MODL*, FbxCluster*>& BoneToCluster);
+		FbxSurfacePhong* MATDToFBXMaterial(const MATD& material);
+		void ReadMSH(const fs::path& mshFilePath);
+		vector<SegmentGeometry> GetSegmentGeometry(const size_t modelIndex);
+		static bool PrepareMesh(MODL& model, const vector<SegmentGeometry>& segments, PreparedMesh& prepared);
+		static void ReleaseGeometry(MODL& model, const bool bKeepSkinning);
+		template<bool bMaterials>
+		bool MODLToFBXMesh(MODL& model, const PreparedMesh& prepared, MATL& materials, FbxNode* meshNode);
+		template<bool bMaterials>
+		bool MODLToFBXMeshStreamed(MODL& model, const vector<SegmentGeometry>& segments, MATL& materials, FbxNode* meshNode);
+		static void AppendTriangles(FbxMesh* mesh, const vector<int32_t>& triangles);
+		template<bool bMaterials>
+		void SegmentMaterialsToFBX(FbxMesh* mesh, const vector<std::pair<uint32_t, size_t>>& segmentMaterials, MATL& materials, FbxNode* meshNode);
 		bool MODLToFBXSkeleton(MODL& model, FbxNode* boneNode);
+		bool AddMSH(const fs::path& mshFileName, const SourceInfo& sourceInfo);
 		void CheckHierarchy();
+		string SourceKey(const fs::path& mshFileName) const;
+		static string HashFile(const fs::path& mshFileName);
+		static bool ReadSourceInfo(const fs::path& mshFileName, SourceInfo& info);
+		static string GetStackProperty(FbxAnimStack* animStack, const char* name);
+		static void SetStackProperty(FbxAnimStack* animStack, const char* name, const string& value);
+		static int CountCurveNodeChannels(FbxAnimCurve* curve);
+		void DestroyAnimStack(FbxAnimStack* animStack);
+
+		unique_ptr<ThreadPool> Workers;
+
+		// Global transforms of all nodes, see GetGlobalTransform
+		TransformCache Transforms;
 
 		// Current State
 		bool bRunning = false;
 		fs::path FbxFilePath;
 		MSH* Mesh = nullptr;
+		bool bOwnsMesh = false;		// Mesh has been read by us, so we may modify it
+		vector<CRCChecksum> ModelCRCs;	// name CRC of each model of Mesh, by model index
+		MSHScanner MappedMSH;			// the file Mesh has been read from, see bLazyParsing
+		vector<vector<SegmentGeometry>> MappedGeometry;	// in place in MappedMSH, by model index. Empty if Mesh has been read otherwise
 		FbxScene* Scene = nullptr;
 		FbxManager* Manager = nullptr;
+		FbxIOSettings* IOSettings = nullptr;
+		FbxExporter* Exporter = nullptr;
 		FbxPose* Bindpose = nullptr;
-		MSH* Basepose = nullptr;
+		std::shared_ptr<const ParsedBasepose> Basepose;	// kept across Close, see Start
+		string CurrentSource = "";
+		SourceInfo CurrentSourceInfo;
 
 		// Logging
 		static void ReceiveLogFromLib(const LoggerEntry* entry);
@@ -3,4 +3,12 @@
 // Include this header to use this static lib
 
 #include "req.h"
+#include "BoneSet.h"
+#include "ThreadPool.h"
+#include "TransformCache.h"
+#include "BaseposeCache.h"
+#include "NameCRC.h"
+#include "FbxMemoryPool.h"
+#include "MappedFile.h"
+#include "MSHScanner.h"
 #include "Converter.h"
\ No newline at end of file
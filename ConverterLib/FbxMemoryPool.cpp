@@ -0,0 +1,326 @@
+#include "stdafx.h"
+#include "FbxMemoryPool.h"
+
+namespace ConverterLib
+{
+	static constexpr size_t SlabSize = 64 * 1024;
+	static constexpr size_t ClassSizes[] = { 16, 32, 48, 64, 96, 128, 192, 256, 384, 512 };
+	static constexpr size_t NumClasses = sizeof(ClassSizes) / sizeof(ClassSizes[0]);
+	static constexpr size_t MaxPooledSize = ClassSizes[NumClasses - 1];
+
+	// size class for every multiple of 16 up to MaxPooledSize
+	static constexpr std::array<uint8_t, MaxPooledSize / 16 + 1> MakeClassLookup()
+	{
+		std::array<uint8_t, MaxPooledSize / 16 + 1> lookup{};
+		uint8_t sizeClass = 0;
+		for (size_t i = 0; i < lookup.size(); ++i)
+		{
+			while (ClassSizes[sizeClass] < i * 16)
+			{
+				++sizeClass;
+			}
+			lookup[i] = sizeClass;
+		}
+		return lookup;
+	}
+
+	static constexpr std::array<uint8_t, MaxPooledSize / 16 + 1> ClassLookup = MakeClassLookup();
+
+	class Pool
+	{
+	public:
+		void* Malloc(size_t size)
+		{
+			Allocations.fetch_add(1, std::memory_order_relaxed);
+			if (size > MaxPooledSize)
+			{
+				return DefaultMalloc(size);
+			}
+
+			const uint8_t sizeClass = ClassLookup[(std::max<size_t>(size, 1) + 15) / 16];
+
+			std::lock_guard<std::mutex> lock(Mutex);
+			if (FreeLists[sizeClass] == nullptr && !AddSlab(sizeClass))
+			{
+				return nullptr;
+			}
+
+			FreeBlock* block = FreeLists[sizeClass];
+			FreeLists[sizeClass] = block->Next;
+			++FindSlab(block)->second.LiveBlocks;
+
+			PooledAllocations.fetch_add(1, std::memory_order_relaxed);
+			return block;
+		}
+
+		void* Calloc(size_t count, size_t size)
+		{
+			if (size != 0 && count > SIZE_MAX / size)
+			{
+				return nullptr;
+			}
+
+			void* ptr = Malloc(count * size);
+			if (ptr != nullptr)
+			{
+				memset(ptr, 0, count * size);
+			}
+			return ptr;
+		}
+
+		void* Realloc(void* ptr, size_t size)
+		{
+			if (ptr == nullptr)
+			{
+				return Malloc(size);
+			}
+			if (size == 0)
+			{
+				Free(ptr);
+				return nullptr;
+			}
+
+			if (!MayOwn(ptr))
+			{
+				return DefaultRealloc(ptr, size);
+			}
+
+			size_t oldSize;
+			{
+				std::lock_guard<std::mutex> lock(Mutex);
+				auto slab = FindSlab(ptr);
+				if (slab == Slabs.end())
+				{
+					// not ours, so it stays with the SDK's handlers
+					return DefaultRealloc(ptr, size);
+				}
+				oldSize = ClassSizes[slab->second.SizeClass];
+			}
+
+			if (size <= oldSize)
+			{
+				return ptr;
+			}
+
+			void* newPtr = Malloc(size);
+			if (newPtr != nullptr)
+			{
+				memcpy(newPtr, ptr, oldSize);
+				Free(ptr);
+			}
+			return newPtr;
+		}
+
+		void Free(void* ptr)
+		{
+			if (ptr == nullptr)
+			{
+				return;
+			}
+			Frees.fetch_add(1, std::memory_order_relaxed);
+
+			if (MayOwn(ptr))
+			{
+				std::lock_guard<std::mutex> lock(Mutex);
+				auto slab = FindSlab(ptr);
+				if (slab != Slabs.end())
+				{
+					FreeBlock* block = (FreeBlock*)ptr;
+					block->Next = FreeLists[slab->second.SizeClass];
+					FreeLists[slab->second.SizeClass] = block;
+					--slab->second.LiveBlocks;
+					return;
+				}
+			}
+
+			// allocated by the SDK's handlers (too large, or before we got installed)
+			DefaultFree(ptr);
+		}
+
+		void Trim()
+		{
+			std::lock_guard<std::mutex> lock(Mutex);
+
+			// unlink all blocks of empty slabs from the free lists first
+			for (size_t sizeClass = 0; sizeClass < NumClasses; ++sizeClass)
+			{
+				FreeBlock** link = &FreeLists[sizeClass];
+				while (*link != nullptr)
+				{
+					if (FindSlab(*link)->second.LiveBlocks == 0)
+					{
+						*link = (*link)->Next;
+					}
+					else
+					{
+						link = &(*link)->Next;
+					}
+				}
+			}
+
+			for (auto slab = Slabs.begin(); slab != Slabs.end();)
+			{
+				if (slab->second.LiveBlocks == 0)
+				{
+					FreeSlabMemory((void*)slab->first);
+					slab = Slabs.erase(slab);
+				}
+				else
+				{
+					++slab;
+				}
+			}
+		}
+
+		FbxMemoryStats GetStats()
+		{
+			FbxMemoryStats stats;
+			stats.Allocations = Allocations.load(std::memory_order_relaxed);
+			stats.PooledAllocations = PooledAllocations.load(std::memory_order_relaxed);
+			stats.Frees = Frees.load(std::memory_order_relaxed);
+
+			std::lock_guard<std::mutex> lock(Mutex);
+			stats.Slabs = Slabs.size();
+			stats.SlabBytes = Slabs.size() * SlabSize;
+			return stats;
+		}
+
+		FbxMallocProc DefaultMalloc = nullptr;
+		FbxReallocProc DefaultRealloc = nullptr;
+		FbxFreeProc DefaultFree = nullptr;
+
+	private:
+		struct FreeBlock
+		{
+			FreeBlock* Next;
+		};
+
+		struct Slab
+		{
+			uint8_t SizeClass;
+			size_t LiveBlocks;
+		};
+
+		std::mutex Mutex;
+		FreeBlock* FreeLists[NumClasses] = {};
+
+		// by slab address. Slabs are aligned to their size, so the
+		// slab of any block is found by masking the blocks address
+		std::unordered_map<uintptr_t, Slab> Slabs;
+
+		std::atomic<uint64_t> Allocations{ 0 };
+		std::atomic<uint64_t> PooledAllocations{ 0 };
+		std::atomic<uint64_t> Frees{ 0 };
+
+		// address range covered by all slabs so far. Only ever grows
+		std::atomic<uintptr_t> SlabsBegin{ UINTPTR_MAX };
+		std::atomic<uintptr_t> SlabsEnd{ 0 };
+
+		// Blocks outside of all slabs ever allocated can't be ours. Lets most
+		// large blocks skip the lock and the slab lookup
+		bool MayOwn(const void* ptr) const
+		{
+			const uintptr_t address = (uintptr_t)ptr;
+			return address >= SlabsBegin.load(std::memory_order_acquire) && address < SlabsEnd.load(std::memory_order_acquire);
+		}
+
+		std::unordered_map<uintptr_t, Slab>::iterator FindSlab(const void* ptr)
+		{
+			return Slabs.find((uintptr_t)ptr & ~(uintptr_t)(SlabSize - 1));
+		}
+
+		bool AddSlab(const uint8_t sizeClass)
+		{
+#ifdef _WIN32
+			uint8_t* memory = (uint8_t*)_aligned_malloc(SlabSize, SlabSize);
+#else
+			uint8_t* memory = (uint8_t*)std::aligned_alloc(SlabSize, SlabSize);
+#endif
+			if (memory == nullptr)
+			{
+				return false;
+			}
+			Slabs[(uintptr_t)memory] = { sizeClass, 0 };
+			SlabsBegin.store(std::min(SlabsBegin.load(std::memory_order_relaxed), (uintptr_t)memory), std::memory_order_release);
+			SlabsEnd.store(std::max(SlabsEnd.load(std::memory_order_relaxed), (uintptr_t)memory + SlabSize), std::memory_order_release);
+
+			const size_t blockSize = ClassSizes[sizeClass];
+			for (size_t offset = 0; offset + blockSize <= SlabSize; offset += blockSize)
+			{
+				FreeBlock* block = (FreeBlock*)(memory + offset);
+				block->Next = FreeLists[sizeClass];
+				FreeLists[sizeClass] = block;
+			}
+			return true;
+		}
+
+		static void FreeSlabMemory(void* memory)
+		{
+#ifdef _WIN32
+			_aligned_free(memory);
+#else
+			std::free(memory);
+#endif
+		}
+	};
+
+	// Never destroyed, since the SDK may still free blocks during static destruction
+	static Pool* Instance = nullptr;
+	static std::once_flag InstallFlag;
+
+	static void* PoolMalloc(size_t size)
+	{
+		return Instance->Malloc(size);
+	}
+
+	static void* PoolCalloc(size_t count, size_t size)
+	{
+		return Instance->Calloc(count, size);
+	}
+
+	static void* PoolRealloc(void* ptr, size_t size)
+	{
+		return Instance->Realloc(ptr, size);
+	}
+
+	static void PoolFree(void* ptr)
+	{
+		Instance->Free(ptr);
+	}
+
+	void FbxMemoryPool::Install()
+	{
+		std::call_once(InstallFlag, []()
+		{
+			Instance = new Pool();
+
+			// the SDK's own handlers, which use the SDK's C runtime heap
+			Instance->DefaultMalloc = FbxGetMallocHandler();
+			Instance->DefaultRealloc = FbxGetReallocHandler();
+			Instance->DefaultFree = FbxGetFreeHandler();
+
+			FbxSetMallocHandler(&PoolMalloc);
+			FbxSetCallocHandler(&PoolCalloc);
+			FbxSetReallocHandler(&PoolRealloc);
+			FbxSetFreeHandler(&PoolFree);
+		});
+	}
+
+	bool FbxMemoryPool::IsInstalled()
+	{
+		return Instance != nullptr;
+	}
+
+	void FbxMemoryPool::Trim()
+	{
+		if (Instance != nullptr)
+		{
+			Instance->Trim();
+		}
+	}
+
+	FbxMemoryStats FbxMemoryPool::GetStats()
+	{
+		return Instance != nullptr ? Instance->GetStats() : FbxMemoryStats();
+	}
+}
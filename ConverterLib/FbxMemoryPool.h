@@ -0,0 +1,31 @@
+#pragma once
+
+namespace ConverterLib
+{
+	struct FbxMemoryStats
+	{
+		uint64_t Allocations = 0;		// all FBX SDK allocations, including reallocations to a new block
+		uint64_t PooledAllocations = 0;	// served from the pool
+		uint64_t Frees = 0;
+		size_t Slabs = 0;				// currently held by the pool
+		size_t SlabBytes = 0;
+	};
+
+	// Process wide pool for the many small allocations of the FBX SDK (nodes, properties,
+	// curve keys, ...). Small blocks are served from per size class free lists carved out
+	// of 64 KiB slabs, everything else is passed on to the SDK's own handlers.
+	// Opt-in: nothing is pooled unless Install is called (CLI: --pooled-fbx-alloc)
+	class FbxMemoryPool
+	{
+	public:
+		// Routes all FBX SDK allocations through the pool. Has to happen before the
+		// first FbxManager is created (i.e. the first Converter::Start). Subsequent calls do nothing
+		static void Install();
+		static bool IsInstalled();
+
+		// Releases all slabs not holding any live block anymore, e.g. after a Scene got destroyed
+		static void Trim();
+
+		static FbxMemoryStats GetStats();
+	};
+}
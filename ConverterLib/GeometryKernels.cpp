@@ -0,0 +1,148 @@
+#include "stdafx.h"
+#include "GeometryKernels.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace ConverterLib
+{
+	namespace GeometryKernels
+	{
+		// We're reading from / writing to the raw list storages, so make sure
+		// there's nothing but the plain components in there
+		static_assert(sizeof(Vector2) == 2 * sizeof(float), "Vector2 is expected to be two packed floats!");
+		static_assert(sizeof(Vector3) == 3 * sizeof(float), "Vector3 is expected to be three packed floats!");
+		static_assert(sizeof(FbxVector2) == 2 * sizeof(double), "FbxVector2 is expected to be two packed doubles!");
+		static_assert(sizeof(FbxVector4) == 4 * sizeof(double), "FbxVector4 is expected to be four packed doubles!");
+
+		void WidenVectors(const Vector3* src, FbxVector4* dst, size_t count)
+		{
+			size_t i = 0;
+
+#if defined(__AVX2__)
+			const float* in = &src[0].m_X;
+			double* out = &dst[0][0];
+			const __m256d one = _mm256_set1_pd(1.0);
+
+			// Every load grabs 4 floats (X, Y, Z of this vector and X of the next),
+			// so leave the last vector to the scalar loop to not read past the end
+			for (; i + 1 < count; ++i)
+			{
+				__m256d wide = _mm256_cvtps_pd(_mm_loadu_ps(in + i * 3));
+				_mm256_storeu_pd(out + i * 4, _mm256_blend_pd(wide, one, 0b1000));
+			}
+#endif
+
+			for (; i < count; ++i)
+			{
+				dst[i] = FbxVector4(src[i].m_X, src[i].m_Y, src[i].m_Z);
+			}
+		}
+
+		void WidenVectors(const Vector2* src, FbxVector2* dst, size_t count)
+		{
+			size_t i = 0;
+
+#if defined(__AVX2__)
+			const float* in = &src[0].m_X;
+			double* out = &dst[0][0];
+
+			// two vectors at a time
+			for (; i + 2 <= count; i += 2)
+			{
+				_mm256_storeu_pd(out + i * 2, _mm256_cvtps_pd(_mm_loadu_ps(in + i * 2)));
+			}
+#endif
+
+			for (; i < count; ++i)
+			{
+				dst[i] = FbxVector2(src[i].m_X, src[i].m_Y);
+			}
+		}
+	
+		// |ab x ac|^2 = |ab|^2 * |ac|^2 * sin^2(angle), so comparing against the
+		// squared edge lengths tests the angle at 'a', independent of the models scale.
+		// Done in double, so the products of tiny edges don't underflow
+		static bool IsDegenerated(const Vector3& a, const Vector3& b, const Vector3& c)
+		{
+			const double MaxSinSquared = 1e-10;	// about 0.0006 degrees
+
+			const double abX = (double)b.m_X - a.m_X, abY = (double)b.m_Y - a.m_Y, abZ = (double)b.m_Z - a.m_Z;
+			const double acX = (double)c.m_X - a.m_X, acY = (double)c.m_Y - a.m_Y, acZ = (double)c.m_Z - a.m_Z;
+
+			const double crossX = abY * acZ - abZ * acY;
+			const double crossY = abZ * acX - abX * acZ;
+			const double crossZ = abX * acY - abY * acX;
+
+			const double abSquared = abX * abX + abY * abY + abZ * abZ;
+			const double acSquared = acX * acX + acY * acY + acZ * acZ;
+			return (crossX * crossX + crossY * crossY + crossZ * crossZ) <= MaxSinSquared * abSquared * acSquared;
+		}
+
+		size_t DecodeTriangleStrips(const uint16_t* strips, size_t count, const Vector3* positions, size_t numPositions, int32_t indexOffset, vector<int32_t>& triangles)
+		{
+			const uint16_t StripStart = 0x8000;
+			const uint16_t IndexMask = 0x7FFF;
+
+			// a strip of n indices yields at most n - 2 triangles
+			triangles.reserve(triangles.size() + count * 3);
+			const size_t sizeBefore = triangles.size();
+
+			uint16_t window[2] = { 0, 0 };
+			size_t stripPos = 0;
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				const uint16_t raw = strips[i];
+
+				if ((raw & StripStart) != 0 && i + 1 < count && (strips[i + 1] & StripStart) != 0)
+				{
+					window[0] = raw & IndexMask;
+					window[1] = strips[++i] & IndexMask;
+					stripPos = 2;
+					continue;
+				}
+
+				const uint16_t index = raw & IndexMask;
+				if (stripPos < 2)
+				{
+					window[stripPos++] = index;
+					continue;
+				}
+
+				// odd triangles within a strip have flipped winding
+				uint16_t a = window[0], b = window[1], c = index;
+				if (((stripPos - 2) & 1) != 0)
+				{
+					std::swap(a, b);
+				}
+
+				window[0] = window[1];
+				window[1] = index;
+				++stripPos;
+
+				if (a == b || b == c || a == c)
+				{
+					continue;
+				}
+
+				if (a >= numPositions || b >= numPositions || c >= numPositions)
+				{
+					continue;
+				}
+
+				if (positions != nullptr && IsDegenerated(positions[a], positions[b], positions[c]))
+				{
+					continue;
+				}
+
+				triangles.push_back(a + indexOffset);
+				triangles.push_back(b + indexOffset);
+				triangles.push_back(c + indexOffset);
+			}
+
+			return (triangles.size() - sizeBefore) / 3;
+		}
+	}
+}
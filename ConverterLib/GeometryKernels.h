@@ -0,0 +1,26 @@
+#pragma once
+
+namespace ConverterLib
+{
+	using LibSWBF2::Types::Vector2;
+	using LibSWBF2::Types::Vector3;
+
+	namespace GeometryKernels
+	{
+		// Widen MSH float vectors into FBX double vectors, writing straight
+		// into the FBX owned arrays. Uses AVX2 when compiled with it (see
+		// MSH2FBX_AVX2 in CMakeLists.txt), scalar code otherwise.
+		// W of the resulting FbxVector4s is set to 1.0, like FbxVector4's default.
+		void WidenVectors(const Vector3* src, FbxVector4* dst, size_t count);
+		void WidenVectors(const Vector2* src, FbxVector2* dst, size_t count);
+
+		// Decodes MSH triangle strips (STRP) into a flat triangle list, appending
+		// three indices per triangle to 'triangles', each shifted by 'indexOffset'.
+		// A new strip starts with two indices having the high bit (0x8000) set.
+		// Every other triangle of a strip gets its winding flipped.
+		// Degenerated triangles (repeated indices, or collinear corners if 'positions'
+		// are given) and triangles referencing out of range vertices are dropped.
+		// Returns the number of triangles appended.
+		size_t DecodeTriangleStrips(const uint16_t* strips, size_t count, const Vector3* positions, size_t numPositions, int32_t indexOffset, vector<int32_t>& triangles);
+	}
+}
@@ -0,0 +1,699 @@
+#include "stdafx.h"
+#include "MappedFile.h"
+#include "MSHScanner.h"
+#include "NameCRC.h"
+
+namespace ConverterLib
+{
+	using namespace LibSWBF2::Chunks::MSH;
+	using namespace LibSWBF2::Types;
+
+	static uint32_t TagOf(const char* tag)
+	{
+		uint32_t value;
+		memcpy(&value, tag, sizeof(value));
+		return value;
+	}
+
+	bool ChunkView::IsValid() const
+	{
+		return Data != nullptr;
+	}
+
+	bool ChunkView::Is(const char* tag) const
+	{
+		return IsValid() && Tag == TagOf(tag);
+	}
+
+	bool ChunkView::NextChild(size_t& position, ChunkView& child) const
+	{
+		size_t header = position;
+		uint32_t tag, size;
+		if (!Read(header, tag) || !Read(header, size) || size > Size - header)
+		{
+			return false;
+		}
+
+		child.Tag = tag;
+		child.Data = Data + header;
+		child.Size = size;
+
+		// chunk data is padded to four bytes
+		position = std::min(header + (((size_t)size + 3) & ~(size_t)3), Size);
+		return true;
+	}
+
+	ChunkView ChunkView::FindChild(const char* tag, size_t offset) const
+	{
+		ChunkView child;
+		while (NextChild(offset, child))
+		{
+			if (child.Is(tag))
+			{
+				return child;
+			}
+		}
+		return ChunkView();
+	}
+
+	ChunkView ChunkView::FromBuffer(const uint8_t* data, size_t size)
+	{
+		ChunkView view;
+		view.Data = data;
+		view.Size = size;
+		return view;
+	}
+
+	bool MSHScanner::Open(const fs::path& mshFilePath)
+	{
+		return File.Open(mshFilePath);
+	}
+
+	void MSHScanner::Close()
+	{
+		File.Close();
+	}
+
+	ChunkView MSHScanner::GetRoot() const
+	{
+		return ChunkView::FromBuffer(File.GetData(), File.GetSize()).FindChild("HEDR");
+	}
+
+	// KFR3 keys, as stored in the file
+	struct PackedTranslationKey
+	{
+		uint32_t FrameIndex;
+		float X, Y, Z;
+	};
+
+	struct PackedRotationKey
+	{
+		uint32_t FrameIndex;
+		float X, Y, Z, W;
+	};
+
+	static_assert(sizeof(PackedTranslationKey) == 16 && sizeof(PackedRotationKey) == 20, "KFR3 keys are expected to be packed!");
+
+	// Geometry records, as stored in the file
+	struct PackedVector2
+	{
+		float X, Y;
+	};
+
+	struct PackedVector3
+	{
+		float X, Y, Z;
+	};
+
+	struct PackedWeights
+	{
+		struct
+		{
+			uint32_t EnvelopeIndex;
+			float Value;
+		} Weights[4];
+	};
+
+	// TRAN: scale, rotation (quaternion), translation
+	struct PackedTransform
+	{
+		PackedVector3 Scale;
+		float RotationX, RotationY, RotationZ, RotationW;
+		PackedVector3 Translation;
+	};
+
+	// DATA of MATD: diffuse, specular and ambient color (RGBA), specular sharpness
+	struct PackedMaterialData
+	{
+		float Diffuse[4];
+		float Specular[4];
+		float Ambient[4];
+		float SpecularSharpness;
+	};
+
+	static_assert(sizeof(PackedWeights) == 32 && sizeof(PackedTransform) == 40 && sizeof(PackedMaterialData) == 52, "MSH2 records are expected to be packed!");
+
+	static bool ReadCycles(const ChunkView& cycl, List<Animation>& cycles)
+	{
+		size_t position = 0;
+		uint32_t numCycles;
+		if (!cycl.Read(position, numCycles))
+		{
+			return false;
+		}
+
+		for (uint32_t i = 0; i < numCycles; ++i)
+		{
+			char name[64];
+			float frameRate;
+			uint32_t playStyle, firstFrame, lastFrame;
+			if (!cycl.Read(position, name) || !cycl.Read(position, frameRate) || !cycl.Read(position, playStyle) ||
+				!cycl.Read(position, firstFrame) || !cycl.Read(position, lastFrame))
+			{
+				return false;
+			}
+			name[sizeof(name) - 1] = 0;
+
+			Animation& cycle = cycles.Emplace();
+			cycle.m_AnimationName = String(name);
+			cycle.m_FrameRate = frameRate;
+			cycle.m_PlayStyle = playStyle;
+			cycle.m_FirstFrame = firstFrame;
+			cycle.m_LastFrame = lastFrame;
+		}
+		return true;
+	}
+
+	static bool ReadKeyFrames(const ChunkView& kfr3, List<BoneFrames>& bones)
+	{
+		size_t position = 0;
+		uint32_t numBones;
+		if (!kfr3.Read(position, numBones))
+		{
+			return false;
+		}
+
+		for (uint32_t i = 0; i < numBones; ++i)
+		{
+			uint32_t crc, keyFrameType, numTranslations, numRotations;
+			if (!kfr3.Read(position, crc) || !kfr3.Read(position, keyFrameType) ||
+				!kfr3.Read(position, numTranslations) || !kfr3.Read(position, numRotations))
+			{
+				return false;
+			}
+
+			// views are bounds checked, so the counts can be trusted for allocation afterwards
+			ArrayView<PackedTranslationKey> translations;
+			ArrayView<PackedRotationKey> rotations;
+			if (!kfr3.ReadArray(position, numTranslations, translations) || !kfr3.ReadArray(position, numRotations, rotations))
+			{
+				return false;
+			}
+
+			BoneFrames& bone = bones.Emplace();
+			bone.m_CRCchecksum = crc;
+			bone.m_KeyFrameType = keyFrameType;
+
+			for (size_t t = 0; t < translations.Size(); ++t)
+			{
+				const PackedTranslationKey key = translations[t];
+				TranslationFrame& frame = bone.m_TranslationFrames.Emplace();
+				frame.m_FrameIndex = key.FrameIndex;
+				frame.m_Translation.m_X = key.X;
+				frame.m_Translation.m_Y = key.Y;
+				frame.m_Translation.m_Z = key.Z;
+			}
+
+			for (size_t r = 0; r < rotations.Size(); ++r)
+			{
+				const PackedRotationKey key = rotations[r];
+				RotationFrame& frame = bone.m_RotationFrames.Emplace();
+				frame.m_FrameIndex = key.FrameIndex;
+				frame.m_Rotation.m_X = key.X;
+				frame.m_Rotation.m_Y = key.Y;
+				frame.m_Rotation.m_Z = key.Z;
+				frame.m_Rotation.m_W = key.W;
+			}
+		}
+		return true;
+	}
+
+	bool MSHScanner::ReadAnimations(ANM2& animations) const
+	{
+		const ChunkView root = GetRoot();
+		if (!root.IsValid())
+		{
+			return false;
+		}
+
+		const ChunkView anm2 = root.FindChild("ANM2");
+		if (!anm2.IsValid())
+		{
+			return true;
+		}
+
+		const ChunkView cycl = anm2.FindChild("CYCL");
+		if (cycl.IsValid() && !ReadCycles(cycl, animations.m_AnimationCycle.m_Animations))
+		{
+			return false;
+		}
+
+		const ChunkView kfr3 = anm2.FindChild("KFR3");
+		if (kfr3.IsValid() && !ReadKeyFrames(kfr3, animations.m_KeyFrames.m_BoneFrames))
+		{
+			return false;
+		}
+		return true;
+	}
+
+	// MSH strings are zero terminated within their (padded) chunk
+	static string ReadString(const ChunkView& chunk)
+	{
+		const char* text = (const char*)chunk.Data;
+		return string(text, std::find(text, text + chunk.Size, '\0'));
+	}
+
+	static uint32_t ReadCount(const ChunkView& chunk)
+	{
+		size_t position = 0;
+		uint32_t count = 0;
+		chunk.Read(position, count);
+		return count;
+	}
+
+	// Every strip starts with two flagged indices and yields
+	// two triangles less than it has indices
+	static uint32_t CountStripTriangles(const ChunkView& strp)
+	{
+		size_t position = 0;
+		uint32_t numIndices;
+		ArrayView<uint16_t> indices;
+		if (!strp.Read(position, numIndices) || !strp.ReadArray(position, numIndices, indices))
+		{
+			return 0;
+		}
+
+		uint32_t numFlagged = 0;
+		for (size_t i = 0; i < indices.Size(); ++i)
+		{
+			numFlagged += (indices[i] & 0x8000) != 0;
+		}
+		return numIndices > numFlagged ? numIndices - numFlagged : 0;
+	}
+
+	static void ReadMaterials(const ChunkView& matl, MSHSummary& summary)
+	{
+		// a material count precedes the MATD chunks
+		size_t position = sizeof(uint32_t);
+		ChunkView matd;
+		while (matl.NextChild(position, matd))
+		{
+			if (!matd.Is("MATD"))
+			{
+				continue;
+			}
+
+			MSHSummary::Material& material = summary.Materials.emplace_back();
+			size_t childPosition = 0;
+			ChunkView child;
+			while (matd.NextChild(childPosition, child))
+			{
+				if (child.Is("NAME"))
+				{
+					material.Name = ReadString(child);
+				}
+				else if (child.Is("TX0D") || child.Is("TX1D") || child.Is("TX2D") || child.Is("TX3D"))
+				{
+					string texture = ReadString(child);
+					if (!texture.empty())
+					{
+						material.Textures.emplace_back(std::move(texture));
+					}
+				}
+			}
+		}
+	}
+
+	static void ReadModel(const ChunkView& modl, MSHSummary& summary)
+	{
+		MSHSummary::Model& model = summary.Models.emplace_back();
+
+		size_t position = 0;
+		ChunkView child;
+		while (modl.NextChild(position, child))
+		{
+			if (child.Is("MTYP"))
+			{
+				model.ModelType = ReadCount(child);
+			}
+			else if (child.Is("NAME"))
+			{
+				model.Name = ReadString(child);
+			}
+			else if (child.Is("PRNT"))
+			{
+				model.Parent = ReadString(child);
+			}
+			else if (child.Is("GEOM"))
+			{
+				size_t geomPosition = 0;
+				ChunkView segm;
+				while (child.NextChild(geomPosition, segm))
+				{
+					if (!segm.Is("SEGM"))
+					{
+						continue;
+					}
+
+					MSHSummary::Segment& segment = model.Segments.emplace_back();
+					size_t segmPosition = 0;
+					ChunkView data;
+					while (segm.NextChild(segmPosition, data))
+					{
+						if (data.Is("MATI"))
+						{
+							segment.MaterialIndex = ReadCount(data);
+						}
+						else if (data.Is("POSL"))
+						{
+							segment.NumVertices = ReadCount(data);
+						}
+						else if (data.Is("STRP"))
+						{
+							segment.NumTriangles = CountStripTriangles(data);
+						}
+					}
+				}
+			}
+		}
+
+		// let LibSWBF2 classify the model, so purposes match the ones used for filtering
+		MODL classified;
+		classified.m_Name.m_Text = String(model.Name.c_str());
+		classified.m_Parent.m_Text = String(model.Parent.c_str());
+		classified.m_ModelType.m_ModelType = (decltype(classified.m_ModelType.m_ModelType))model.ModelType;
+		model.Purpose = classified.GetPurpose();
+
+		if ((model.Purpose & EModelPurpose::Skeleton) != 0)
+		{
+			summary.Bones.push_back({ model.Name, NameCRC::CalcLowerCRC(model.Name.c_str(), model.Name.size()) });
+		}
+	}
+
+	bool MSHScanner::ReadSummary(MSHSummary& summary) const
+	{
+		const ChunkView root = GetRoot();
+		if (!root.IsValid())
+		{
+			return false;
+		}
+
+		const ChunkView msh2 = root.FindChild("MSH2");
+		if (msh2.IsValid())
+		{
+			size_t position = 0;
+			ChunkView child;
+			while (msh2.NextChild(position, child))
+			{
+				if (child.Is("MATL"))
+				{
+					ReadMaterials(child, summary);
+				}
+				else if (child.Is("MODL"))
+				{
+					ReadModel(child, summary);
+				}
+			}
+		}
+
+		const ChunkView anm2 = root.FindChild("ANM2");
+		if (anm2.IsValid())
+		{
+			List<Animation> cycles;
+			const ChunkView cycl = anm2.FindChild("CYCL");
+			if (cycl.IsValid() && !ReadCycles(cycl, cycles))
+			{
+				return false;
+			}
+
+			for (size_t i = 0; i < cycles.Size(); ++i)
+			{
+				summary.Animations.push_back({ cycles[i].m_AnimationName.Buffer(), cycles[i].m_FrameRate, cycles[i].m_FirstFrame, cycles[i].m_LastFrame });
+			}
+
+			const ChunkView kfr3 = anm2.FindChild("KFR3");
+			if (kfr3.IsValid())
+			{
+				summary.NumAnimatedBones = ReadCount(kfr3);
+			}
+		}
+		return true;
+	}
+
+	// POSL, NRML, UV0L, STRP, WGHT and ENVL: a count, followed by that many records
+	template<typename T>
+	static bool ReadCountedArray(const ChunkView& chunk, ArrayView<T>& view)
+	{
+		size_t position = 0;
+		uint32_t count;
+		return chunk.Read(position, count) && chunk.ReadArray(position, count, view);
+	}
+
+	// Counted array as a pointer into the mapping. In any valid MSH file, geometry arrays are
+	// aligned to four bytes (chunk headers and counts are, and chunk data is padded to four)
+	template<typename T, typename Packed>
+	static bool ReadInPlace(const ChunkView& chunk, const T*& data, size_t& count)
+	{
+		static_assert(sizeof(T) == sizeof(Packed), "Geometry types are expected to match their packed layout in the file!");
+
+		ArrayView<Packed> view;
+		if (!ReadCountedArray(chunk, view) || (uintptr_t)view.Data % alignof(T) != 0)
+		{
+			return false;
+		}
+		data = reinterpret_cast<const T*>(view.Data);
+		count = view.Size();
+		return true;
+	}
+
+	SegmentGeometry SegmentGeometry::FromSegment(SEGM& segment)
+	{
+		SegmentGeometry geometry;
+		geometry.NumVertices = segment.m_VertexList.m_Vertices.Size();
+		geometry.NumNormals = segment.m_NormalList.m_Normals.Size();
+		geometry.NumUVs = segment.m_UVList.m_UVs.Size();
+		geometry.NumStripIndices = segment.m_TriangleList.m_Triangles.Size();
+		geometry.NumWeights = segment.m_WeightList.m_Weights.Size();
+		geometry.Vertices = geometry.NumVertices > 0 ? &segment.m_VertexList.m_Vertices[0] : nullptr;
+		geometry.Normals = geometry.NumNormals > 0 ? &segment.m_NormalList.m_Normals[0] : nullptr;
+		geometry.UVs = geometry.NumUVs > 0 ? &segment.m_UVList.m_UVs[0] : nullptr;
+		geometry.Strips = geometry.NumStripIndices > 0 ? &segment.m_TriangleList.m_Triangles[0] : nullptr;
+		geometry.Weights = geometry.NumWeights > 0 ? &segment.m_WeightList.m_Weights[0] : nullptr;
+		return geometry;
+	}
+
+	static Vector3 ToVector3(const PackedVector3& packed)
+	{
+		Vector3 vector;
+		vector.m_X = packed.X;
+		vector.m_Y = packed.Y;
+		vector.m_Z = packed.Z;
+		return vector;
+	}
+
+	static Color ToColor(const float (&rgba)[4])
+	{
+		Color color;
+		color.m_Red = rgba[0];
+		color.m_Green = rgba[1];
+		color.m_Blue = rgba[2];
+		color.m_Alpha = rgba[3];
+		return color;
+	}
+
+	static bool ReadMaterials(const ChunkView& matl, MATL& materials)
+	{
+		// a material count precedes the MATD chunks
+		size_t position = sizeof(uint32_t);
+		ChunkView matd;
+		while (matl.NextChild(position, matd))
+		{
+			if (!matd.Is("MATD"))
+			{
+				continue;
+			}
+
+			MATD& material = materials.m_Materials.Emplace();
+			size_t childPosition = 0;
+			ChunkView child;
+			while (matd.NextChild(childPosition, child))
+			{
+				if (child.Is("NAME"))
+				{
+					material.m_Name.m_Text = String(ReadString(child).c_str());
+				}
+				else if (child.Is("DATA"))
+				{
+					size_t dataPosition = 0;
+					PackedMaterialData data;
+					if (!child.Read(dataPosition, data))
+					{
+						return false;
+					}
+					material.m_Data.m_Diffuse = ToColor(data.Diffuse);
+					material.m_Data.m_Specular = ToColor(data.Specular);
+					material.m_Data.m_Ambient = ToColor(data.Ambient);
+					material.m_Data.m_SpecularSharpness = data.SpecularSharpness;
+				}
+				else if (child.Is("TX0D"))
+				{
+					material.m_Texture0.m_Text = String(ReadString(child).c_str());
+				}
+			}
+		}
+		return true;
+	}
+
+	static bool ReadSegment(const ChunkView& segm, SEGM& segment, SegmentGeometry& geometry, const bool bWeights)
+	{
+		size_t position = 0;
+		ChunkView data;
+		while (segm.NextChild(position, data))
+		{
+			if (data.Is("MATI"))
+			{
+				segment.m_MaterialIndex.m_MaterialIndex = ReadCount(data);
+			}
+			else if (data.Is("POSL"))
+			{
+				if (!ReadInPlace<Vector3, PackedVector3>(data, geometry.Vertices, geometry.NumVertices))
+				{
+					return false;
+				}
+			}
+			else if (data.Is("NRML"))
+			{
+				if (!ReadInPlace<Vector3, PackedVector3>(data, geometry.Normals, geometry.NumNormals))
+				{
+					return false;
+				}
+			}
+			else if (data.Is("UV0L"))
+			{
+				if (!ReadInPlace<Vector2, PackedVector2>(data, geometry.UVs, geometry.NumUVs))
+				{
+					return false;
+				}
+			}
+			else if (data.Is("STRP"))
+			{
+				if (!ReadInPlace<uint16_t, uint16_t>(data, geometry.Strips, geometry.NumStripIndices))
+				{
+					return false;
+				}
+			}
+			else if (bWeights && data.Is("WGHT"))
+			{
+				if (!ReadInPlace<VertexWeights, PackedWeights>(data, geometry.Weights, geometry.NumWeights))
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	static bool ReadGeometry(const ChunkView& geom, GEOM& geometry, vector<SegmentGeometry>& segments, const bool bWeights)
+	{
+		size_t position = 0;
+		ChunkView child;
+		while (geom.NextChild(position, child))
+		{
+			if (child.Is("SEGM"))
+			{
+				if (!ReadSegment(child, geometry.m_Segments.Emplace(), segments.emplace_back(), bWeights))
+				{
+					return false;
+				}
+			}
+			else if (child.Is("ENVL"))
+			{
+				ArrayView<uint32_t> indices;
+				if (!ReadCountedArray(child, indices))
+				{
+					return false;
+				}
+
+				for (size_t i = 0; i < indices.Size(); ++i)
+				{
+					geometry.m_Envelope.m_ModelIndices.Add(indices[i]);
+				}
+			}
+		}
+		return true;
+	}
+
+	static bool ReadModel(const ChunkView& modl, MODL& model, vector<SegmentGeometry>& segments, const EModelPurpose ignoreFilter, const bool bWeights)
+	{
+		ChunkView geom;
+		size_t position = 0;
+		ChunkView child;
+		while (modl.NextChild(position, child))
+		{
+			if (child.Is("MTYP"))
+			{
+				model.m_ModelType.m_ModelType = (decltype(model.m_ModelType.m_ModelType))ReadCount(child);
+			}
+			else if (child.Is("NAME"))
+			{
+				model.m_Name.m_Text = String(ReadString(child).c_str());
+			}
+			else if (child.Is("PRNT"))
+			{
+				model.m_Parent.m_Text = String(ReadString(child).c_str());
+			}
+			else if (child.Is("TRAN"))
+			{
+				size_t transformPosition = 0;
+				PackedTransform transform;
+				if (!child.Read(transformPosition, transform))
+				{
+					return false;
+				}
+				model.m_Transition.m_Scale = ToVector3(transform.Scale);
+				model.m_Transition.m_Translation = ToVector3(transform.Translation);
+				model.m_Transition.m_Rotation.m_X = transform.RotationX;
+				model.m_Transition.m_Rotation.m_Y = transform.RotationY;
+				model.m_Transition.m_Rotation.m_Z = transform.RotationZ;
+				model.m_Transition.m_Rotation.m_W = transform.RotationW;
+			}
+			else if (child.Is("GEOM"))
+			{
+				geom = child;
+			}
+		}
+
+		// the purpose depends on name and type only, so ignored Models are known before their geometry
+		if (!geom.IsValid() || (model.GetPurpose() & ignoreFilter) != 0)
+		{
+			return true;
+		}
+		return ReadGeometry(geom, model.m_Geometry, segments, bWeights);
+	}
+
+	bool MSHScanner::ReadMeshBlock(MSH2& meshBlock, const EModelPurpose ignoreFilter, const bool bWeights, vector<vector<SegmentGeometry>>& geometry) const
+	{
+		const ChunkView root = GetRoot();
+		if (!root.IsValid())
+		{
+			return false;
+		}
+
+		const ChunkView msh2 = root.FindChild("MSH2");
+		if (!msh2.IsValid())
+		{
+			return true;
+		}
+
+		size_t position = 0;
+		ChunkView child;
+		while (msh2.NextChild(position, child))
+		{
+			if (child.Is("MATL"))
+			{
+				if (!ReadMaterials(child, meshBlock.m_MaterialList))
+				{
+					return false;
+				}
+			}
+			else if (child.Is("MODL"))
+			{
+				if (!ReadModel(child, meshBlock.m_Models.Emplace(), geometry.emplace_back(), ignoreFilter, bWeights))
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+}
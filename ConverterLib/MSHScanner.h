@@ -0,0 +1,183 @@
+#pragma once
+
+namespace ConverterLib
+{
+	using LibSWBF2::Chunks::MSH::ANM2;
+	using LibSWBF2::Chunks::MSH::MSH2;
+	using LibSWBF2::Chunks::MSH::SEGM;
+	using LibSWBF2::Types::Vector2;
+	using LibSWBF2::Types::Vector3;
+	using LibSWBF2::Types::VertexWeights;
+	using LibSWBF2::CRCChecksum;
+	using LibSWBF2::EModelPurpose;
+	namespace fs = std::filesystem;
+
+	// Array of plain data records inside a chunk, read in place. Records
+	// aren't necessarily aligned in the file, so they're copied out on access
+	template<typename T>
+	struct ArrayView
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Only plain data can be viewed in chunks!");
+
+		const uint8_t* Data = nullptr;
+		size_t Count = 0;
+
+		size_t Size() const
+		{
+			return Count;
+		}
+
+		T operator[](const size_t index) const
+		{
+			T value;
+			memcpy(&value, Data + index * sizeof(T), sizeof(T));
+			return value;
+		}
+	};
+
+	// Geometry arrays of one Segment (POSL, NRML, UV0L, STRP and WGHT), read in place
+	// from a mapped MSH file (see MSHScanner::ReadMeshBlock), or from the Lists
+	// of a Segment decoded into memory
+	struct SegmentGeometry
+	{
+		const Vector3* Vertices = nullptr;
+		const Vector3* Normals = nullptr;
+		const Vector2* UVs = nullptr;
+		const uint16_t* Strips = nullptr;
+		const VertexWeights* Weights = nullptr;
+		size_t NumVertices = 0;
+		size_t NumNormals = 0;
+		size_t NumUVs = 0;
+		size_t NumStripIndices = 0;
+		size_t NumWeights = 0;
+
+		static SegmentGeometry FromSegment(SEGM& segment);
+	};
+
+	// One chunk of an MSH file: a four character tag and a 32 bit size, followed
+	// by the chunks data, padded to four bytes. All reads are bounds checked
+	struct ChunkView
+	{
+		uint32_t Tag = 0;
+		const uint8_t* Data = nullptr;
+		size_t Size = 0;
+
+		bool IsValid() const;
+		bool Is(const char* tag) const;
+
+		// Reads the next child chunk at 'position' (relative to Data) and advances past it.
+		// Returns false at the end of the data, or if the child doesn't fit into it
+		bool NextChild(size_t& position, ChunkView& child) const;
+
+		// First child with the given tag. Children start 'offset' bytes into the data
+		ChunkView FindChild(const char* tag, size_t offset = 0) const;
+
+		template<typename T>
+		bool Read(size_t& position, T& value) const
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "Only plain data can be read from chunks!");
+			if (position > Size || Size - position < sizeof(T))
+			{
+				return false;
+			}
+			memcpy(&value, Data + position, sizeof(T));
+			position += sizeof(T);
+			return true;
+		}
+
+		// View of 'count' records at 'position', advancing past them
+		template<typename T>
+		bool ReadArray(size_t& position, const size_t count, ArrayView<T>& view) const
+		{
+			if (position > Size || count > (Size - position) / sizeof(T))
+			{
+				return false;
+			}
+			view.Data = Data + position;
+			view.Count = count;
+			position += count * sizeof(T);
+			return true;
+		}
+
+		static ChunkView FromBuffer(const uint8_t* data, size_t size);
+	};
+
+	// Overview of an MSH files contents, without any geometry or key data
+	struct MSHSummary
+	{
+		struct Material
+		{
+			string Name;
+			vector<string> Textures;	// TX0D - TX3D, empty ones omitted
+		};
+
+		struct Segment
+		{
+			uint32_t MaterialIndex = 0;
+			uint32_t NumVertices = 0;
+			uint32_t NumTriangles = 0;	// as encoded in the strips, including degenerated ones
+		};
+
+		struct Model
+		{
+			string Name;
+			string Parent;
+			uint32_t ModelType = 0;
+			EModelPurpose Purpose = EModelPurpose::Miscellaneous;
+			vector<Segment> Segments;
+		};
+
+		struct Bone
+		{
+			string Name;
+			CRCChecksum CRC = 0;
+		};
+
+		struct Animation
+		{
+			string Name;
+			float FrameRate = 0.0f;
+			uint32_t FirstFrame = 0;
+			uint32_t LastFrame = 0;
+		};
+
+		vector<Material> Materials;
+		vector<Model> Models;
+		vector<Bone> Bones;				// all Models with a Skeleton purpose
+		vector<Animation> Animations;
+		uint32_t NumAnimatedBones = 0;	// bones with key data in KFR3
+	};
+
+	// Walks the chunk tree of a memory mapped MSH file without decoding it, so single
+	// chunks (Animations, or just headers and counts) can be decoded straight from the
+	// mapping. MSH::ReadFromFile always reads and decodes everything
+	class MSHScanner
+	{
+	public:
+		bool Open(const fs::path& mshFilePath);
+
+		// The top level HEDR chunk
+		ChunkView GetRoot() const;
+
+		// Decodes only the Animation chunks (CYCL and KFR3 of ANM2).
+		// A file without Animations yields empty ones
+		bool ReadAnimations(ANM2& animations) const;
+
+		// Decodes the Materials and Models of the MSH2 block, just the parts the Converter
+		// uses. Models whose purpose matches 'ignoreFilter' are listed (Envelopes refer to
+		// Models by index), but their GEOM chunk is skipped. So are the Weights (WGHT) of
+		// all Segments, if 'bWeights' is false. A file without MSH2 block yields no Models.
+		// Vertices, normals, UVs, strips and weights aren't copied into the Segments, but returned
+		// in 'geometry' (by Model, then Segment) pointing into the mapping, which stays
+		// valid until Close
+		bool ReadMeshBlock(MSH2& meshBlock, const EModelPurpose ignoreFilter, const bool bWeights, vector<vector<SegmentGeometry>>& geometry) const;
+
+		void Close();
+
+		// Headers and counts only, nothing is decoded in bulk
+		bool ReadSummary(MSHSummary& summary) const;
+
+	private:
+		MappedFile File;
+	};
+}
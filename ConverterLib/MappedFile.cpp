@@ -0,0 +1,134 @@
+#include "stdafx.h"
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ConverterLib
+{
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+#ifdef _WIN32
+	bool MappedFile::Open(const fs::path& filePath)
+	{
+		Close();
+
+		HANDLE file = CreateFileW(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+		File = file;
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0)
+		{
+			Close();
+			return false;
+		}
+
+		Mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (Mapping == nullptr)
+		{
+			Close();
+			return false;
+		}
+
+		Data = (const uint8_t*)MapViewOfFile((HANDLE)Mapping, FILE_MAP_READ, 0, 0, 0);
+		if (Data == nullptr)
+		{
+			Close();
+			return false;
+		}
+		Size = (size_t)size.QuadPart;
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (Data != nullptr)
+		{
+			UnmapViewOfFile(Data);
+			Data = nullptr;
+		}
+		if (Mapping != nullptr)
+		{
+			CloseHandle((HANDLE)Mapping);
+			Mapping = nullptr;
+		}
+		if (File != nullptr)
+		{
+			CloseHandle((HANDLE)File);
+			File = nullptr;
+		}
+		Size = 0;
+	}
+#else
+	bool MappedFile::Open(const fs::path& filePath)
+	{
+		Close();
+
+		File = open(filePath.c_str(), O_RDONLY);
+		if (File < 0)
+		{
+			return false;
+		}
+
+		struct stat status;
+		if (fstat(File, &status) != 0 || status.st_size <= 0)
+		{
+			Close();
+			return false;
+		}
+
+		void* data = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, File, 0);
+		if (data == MAP_FAILED)
+		{
+			Close();
+			return false;
+		}
+
+		// chunks are read front to back
+		madvise(data, (size_t)status.st_size, MADV_SEQUENTIAL);
+
+		Data = (const uint8_t*)data;
+		Size = (size_t)status.st_size;
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (Data != nullptr)
+		{
+			munmap((void*)Data, Size);
+			Data = nullptr;
+		}
+		if (File >= 0)
+		{
+			close(File);
+			File = -1;
+		}
+		Size = 0;
+	}
+#endif
+
+	const uint8_t* MappedFile::GetData() const
+	{
+		return Data;
+	}
+
+	size_t MappedFile::GetSize() const
+	{
+		return Size;
+	}
+}
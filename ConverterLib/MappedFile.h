@@ -0,0 +1,35 @@
+#pragma once
+
+namespace ConverterLib
+{
+	namespace fs = std::filesystem;
+
+	// Read only memory mapping of a whole file. The data stays valid until
+	// Close is called or the MappedFile is destroyed
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		MappedFile(const MappedFile& other) = delete;
+		MappedFile& operator=(const MappedFile& other) = delete;
+		~MappedFile();
+
+		// Fails for empty files, since there's nothing to map
+		bool Open(const fs::path& filePath);
+		void Close();
+
+		const uint8_t* GetData() const;
+		size_t GetSize() const;
+
+	private:
+		const uint8_t* Data = nullptr;
+		size_t Size = 0;
+
+#ifdef _WIN32
+		void* File = nullptr;		// HANDLE
+		void* Mapping = nullptr;	// HANDLE
+#else
+		int File = -1;
+#endif
+	};
+}
@@ -0,0 +1,107 @@
+#include "stdafx.h"
+#include "NameCRC.h"
+
+namespace ConverterLib
+{
+	namespace NameCRC
+	{
+		// CRC-32/BZIP2 check value. "123456789" has nothing to lower case
+		static_assert(LowerCRC("123456789") == 0xFC891918, "NameCRC doesn't compute the expected CRC-32!");
+
+		// Slice k advances a byte through k further zero bytes. The last four bytes
+		// of every step don't overlap the CRC, so their lower casing is folded into
+		// their slices. The first four are lower cased by table before the XOR
+		struct SliceTables
+		{
+			CRCChecksum Slices[8][256];
+			uint8_t Lower[256];
+
+			SliceTables()
+			{
+				for (uint32_t i = 0; i < 256; ++i)
+				{
+					Lower[i] = (uint8_t)Detail::ToLower((char)i);
+					Slices[0][i] = Detail::Table[i];
+				}
+				for (int k = 1; k < 8; ++k)
+				{
+					for (uint32_t i = 0; i < 256; ++i)
+					{
+						const CRCChecksum prev = Slices[k - 1][i];
+						Slices[k][i] = (prev << 8) ^ Detail::Table[prev >> 24];
+					}
+				}
+				for (int k = 0; k < 4; ++k)
+				{
+					CRCChecksum folded[256];
+					for (uint32_t i = 0; i < 256; ++i)
+					{
+						folded[i] = Slices[k][Lower[i]];
+					}
+					std::copy(folded, folded + 256, Slices[k]);
+				}
+			}
+		};
+
+		static const SliceTables Tables;
+
+		static CRCChecksum CalcSliced(const uint8_t* data, size_t length)
+		{
+			const uint8_t* lower = Tables.Lower;
+			CRCChecksum crc = 0xFFFFFFFF;
+
+			for (; length >= 8; data += 8, length -= 8)
+			{
+				// the CRC overlaps the first four bytes (MSB first)
+				const CRCChecksum high = crc ^ ((CRCChecksum)lower[data[0]] << 24 | (CRCChecksum)lower[data[1]] << 16 | (CRCChecksum)lower[data[2]] << 8 | lower[data[3]]);
+				crc =
+					Tables.Slices[7][high >> 24] ^
+					Tables.Slices[6][(high >> 16) & 0xFF] ^
+					Tables.Slices[5][(high >> 8) & 0xFF] ^
+					Tables.Slices[4][high & 0xFF] ^
+					Tables.Slices[3][data[4]] ^
+					Tables.Slices[2][data[5]] ^
+					Tables.Slices[1][data[6]] ^
+					Tables.Slices[0][data[7]];
+			}
+
+			for (; length > 0; ++data, --length)
+			{
+				crc = (crc << 8) ^ Detail::Table[(crc >> 24) ^ lower[*data]];
+			}
+
+			return ~crc;
+		}
+
+		bool IsCompatible()
+		{
+			static const bool bCompatible = []()
+			{
+				const char* samples[] = { "", "a", "DummyRoot", "bone_root", "BONE_R_UPPERARM", "hp_weapons", "Some Mesh With A Longer Name 0123456789" };
+				for (const char* sample : samples)
+				{
+					if (CalcSliced((const uint8_t*)sample, strlen(sample)) != LibSWBF2::CRC::CalcLowerCRC(sample))
+					{
+						return false;
+					}
+				}
+				return true;
+			}();
+			return bCompatible;
+		}
+
+		CRCChecksum CalcLowerCRC(const char* str)
+		{
+			return CalcLowerCRC(str, strlen(str));
+		}
+
+		CRCChecksum CalcLowerCRC(const char* str, size_t length)
+		{
+			if (!IsCompatible())
+			{
+				return LibSWBF2::CRC::CalcLowerCRC(string(str, length).c_str());
+			}
+			return CalcSliced((const uint8_t*)str, length);
+		}
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+namespace ConverterLib
+{
+	using LibSWBF2::CRCChecksum;
+
+	// CRCs of lower cased names, as MSH files use them to reference models and bones.
+	// Same result as LibSWBF2's CRC::CalcLowerCRC: CRC-32 (0x04C11DB7, MSB first),
+	// initial value and final XOR of 0xFFFFFFFF, over the ASCII lower cased string.
+	namespace NameCRC
+	{
+		namespace Detail
+		{
+			constexpr std::array<CRCChecksum, 256> MakeTable()
+			{
+				std::array<CRCChecksum, 256> table{};
+				for (uint32_t i = 0; i < 256; ++i)
+				{
+					CRCChecksum crc = i << 24;
+					for (int bit = 0; bit < 8; ++bit)
+					{
+						crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : crc << 1;
+					}
+					table[i] = crc;
+				}
+				return table;
+			}
+
+			constexpr std::array<CRCChecksum, 256> Table = MakeTable();
+
+			constexpr char ToLower(const char c)
+			{
+				return c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c;
+			}
+		}
+
+		// Compile time version, for names known up front
+		constexpr CRCChecksum LowerCRC(const char* str)
+		{
+			CRCChecksum crc = 0xFFFFFFFF;
+			for (; *str != 0; ++str)
+			{
+				crc = (crc << 8) ^ Detail::Table[(crc >> 24) ^ (uint8_t)Detail::ToLower(*str)];
+			}
+			return ~crc;
+		}
+
+		// Runtime version, processing eight characters per step (slicing-by-8).
+		// Falls back to LibSWBF2 if the self check (see IsCompatible) failed
+		CRCChecksum CalcLowerCRC(const char* str);
+		CRCChecksum CalcLowerCRC(const char* str, size_t length);
+
+		// Whether our CRCs match the ones of LibSWBF2. Checked once per process
+		bool IsCompatible();
+	}
+}
@@ -0,0 +1,118 @@
+#include "stdafx.h"
+#include "ThreadPool.h"
+
+namespace ConverterLib
+{
+	ThreadPool::ThreadPool(size_t numThreads)
+	{
+		if (numThreads == 0)
+		{
+			numThreads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+		}
+
+		for (size_t i = 1; i < numThreads; ++i)
+		{
+			Workers.emplace_back(&ThreadPool::RunWorker, this);
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(JobsMutex);
+			bStopping = true;
+		}
+		JobsAvailable.notify_all();
+
+		for (std::thread& worker : Workers)
+		{
+			worker.join();
+		}
+	}
+
+	size_t ThreadPool::NumThreads() const
+	{
+		return Workers.size() + 1;
+	}
+
+	void ThreadPool::RunWorker()
+	{
+		while (true)
+		{
+			function<void()> job;
+			{
+				std::unique_lock<std::mutex> lock(JobsMutex);
+				JobsAvailable.wait(lock, [this] { return bStopping || !Jobs.empty(); });
+				if (bStopping && Jobs.empty())
+				{
+					return;
+				}
+				job = std::move(Jobs.front());
+				Jobs.pop();
+			}
+			job();
+		}
+	}
+
+	void ThreadPool::ParallelFor(const size_t count, const function<void(size_t begin, size_t end)>& body)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+
+		// a few ranges per thread, so uneven workloads still balance out
+		const size_t numRanges = std::min(count, NumThreads() * 4);
+		if (Workers.empty() || numRanges == 1)
+		{
+			body(0, count);
+			return;
+		}
+
+		// Ranges are claimed one by one. A helper that gets to run only after
+		// all ranges have been claimed returns without touching 'body', so the
+		// state it shares has to outlive this call (nested calls never deadlock)
+		struct State
+		{
+			const function<void(size_t, size_t)>* Body;
+			size_t Count;
+			size_t NumRanges;
+			std::atomic<size_t> NextRange{ 0 };
+			std::atomic<size_t> NumDone{ 0 };
+			std::mutex DoneMutex;
+			std::condition_variable AllDone;
+		};
+		std::shared_ptr<State> state = std::make_shared<State>();
+		state->Body = &body;
+		state->Count = count;
+		state->NumRanges = numRanges;
+
+		auto runRanges = [](State& s)
+		{
+			size_t range;
+			while ((range = s.NextRange++) < s.NumRanges)
+			{
+				(*s.Body)(range * s.Count / s.NumRanges, (range + 1) * s.Count / s.NumRanges);
+				if (++s.NumDone == s.NumRanges)
+				{
+					std::lock_guard<std::mutex> lock(s.DoneMutex);
+					s.AllDone.notify_all();
+				}
+			}
+		};
+
+		{
+			std::lock_guard<std::mutex> lock(JobsMutex);
+			for (size_t i = 0; i < Workers.size() && i + 1 < numRanges; ++i)
+			{
+				Jobs.emplace([state, runRanges] { runRanges(*state); });
+			}
+		}
+		JobsAvailable.notify_all();
+
+		runRanges(*state);
+
+		std::unique_lock<std::mutex> lock(state->DoneMutex);
+		state->AllDone.wait(lock, [&state] { return state->NumDone == state->NumRanges; });
+	}
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+namespace ConverterLib
+{
+	// Fixed set of worker threads for data parallel conversion steps.
+	// Never touch the FbxScene from within a job, the FBX SDK is not thread safe!
+	class ThreadPool
+	{
+	public:
+		// 0 uses one thread per CPU core. The calling thread counts as
+		// one of them, so a pool of 1 runs everything serially
+		ThreadPool(size_t numThreads = 0);
+		ThreadPool(const ThreadPool& pool) = delete;
+		~ThreadPool();
+
+		size_t NumThreads() const;
+
+		// Calls 'body(begin, end)' for consecutive ranges covering [0, count),
+		// spread across all workers and the calling thread.
+		// Returns once the whole range has been processed
+		void ParallelFor(const size_t count, const function<void(size_t begin, size_t end)>& body);
+
+	private:
+		vector<std::thread> Workers;
+		queue<function<void()>> Jobs;
+		std::mutex JobsMutex;
+		std::condition_variable JobsAvailable;
+		bool bStopping = false;
+
+		void RunWorker();
+	};
+}
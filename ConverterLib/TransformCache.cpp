@@ -0,0 +1,133 @@
+#include "stdafx.h"
+#include "TransformCache.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MSH2FBX_SSE2
+#endif
+
+namespace ConverterLib
+{
+	// FBX's 'parent * local'. FbxAMatrix stores row vectors (translation in the last row),
+	// so on the raw rows this is 'local * parent': each row of the result is a linear
+	// combination of the parents rows, weighted by the respective row of 'local'
+	static void MultiplyGlobal(const FbxAMatrix& parent, const FbxAMatrix& local, FbxAMatrix& out)
+	{
+		static_assert(sizeof(FbxDouble4) == 4 * sizeof(double), "FbxDouble4 is expected to be four packed doubles!");
+
+#if defined(__AVX2__)
+		const __m256d p0 = _mm256_loadu_pd(&parent[0][0]);
+		const __m256d p1 = _mm256_loadu_pd(&parent[1][0]);
+		const __m256d p2 = _mm256_loadu_pd(&parent[2][0]);
+		const __m256d p3 = _mm256_loadu_pd(&parent[3][0]);
+
+		for (int i = 0; i < 4; ++i)
+		{
+			__m256d row = _mm256_mul_pd(_mm256_set1_pd(local[i][0]), p0);
+			row = _mm256_add_pd(row, _mm256_mul_pd(_mm256_set1_pd(local[i][1]), p1));
+			row = _mm256_add_pd(row, _mm256_mul_pd(_mm256_set1_pd(local[i][2]), p2));
+			row = _mm256_add_pd(row, _mm256_mul_pd(_mm256_set1_pd(local[i][3]), p3));
+			_mm256_storeu_pd(&out[i][0], row);
+		}
+#elif defined(MSH2FBX_SSE2)
+		// two doubles per register, so every row is handled in two halves
+		for (int half = 0; half < 4; half += 2)
+		{
+			const __m128d p0 = _mm_loadu_pd(&parent[0][half]);
+			const __m128d p1 = _mm_loadu_pd(&parent[1][half]);
+			const __m128d p2 = _mm_loadu_pd(&parent[2][half]);
+			const __m128d p3 = _mm_loadu_pd(&parent[3][half]);
+
+			for (int i = 0; i < 4; ++i)
+			{
+				__m128d row = _mm_mul_pd(_mm_set1_pd(local[i][0]), p0);
+				row = _mm_add_pd(row, _mm_mul_pd(_mm_set1_pd(local[i][1]), p1));
+				row = _mm_add_pd(row, _mm_mul_pd(_mm_set1_pd(local[i][2]), p2));
+				row = _mm_add_pd(row, _mm_mul_pd(_mm_set1_pd(local[i][3]), p3));
+				_mm_storeu_pd(&out[i][half], row);
+			}
+		}
+#else
+		for (int i = 0; i < 4; ++i)
+		{
+			for (int j = 0; j < 4; ++j)
+			{
+				out[i][j] = local[i][0] * parent[0][j] + local[i][1] * parent[1][j] + local[i][2] * parent[2][j] + local[i][3] * parent[3][j];
+			}
+		}
+#endif
+	}
+
+	static bool IsZero(const FbxVector4& vector)
+	{
+		return vector[0] == 0.0 && vector[1] == 0.0 && vector[2] == 0.0;
+	}
+
+	// Whether the nodes local transform is just translation, XYZ rotation and scale,
+	// inheriting its parents transform as a whole (like all nodes we create)
+	static bool IsPlainTRS(FbxNode* node)
+	{
+		FbxTransform::EInheritType inheritType;
+		node->GetTransformationInheritType(inheritType);
+
+		return !node->GetRotationActive() && inheritType == FbxTransform::eInheritRSrs &&
+			IsZero(node->GetRotationPivot(FbxNode::eSourcePivot)) && IsZero(node->GetRotationOffset(FbxNode::eSourcePivot)) &&
+			IsZero(node->GetScalingPivot(FbxNode::eSourcePivot)) && IsZero(node->GetScalingOffset(FbxNode::eSourcePivot));
+	}
+
+	void TransformCache::Build(FbxNode* root)
+	{
+		Globals.clear();
+		bValid = true;
+
+		if (root != nullptr)
+		{
+			FbxAMatrix identity;
+			identity.SetIdentity();
+			BuildRecursive(root, identity);
+		}
+	}
+
+	void TransformCache::BuildRecursive(FbxNode* node, const FbxAMatrix& parentGlobal)
+	{
+		// entries never move, so children can refer to their parents matrix
+		FbxAMatrix& global = Globals[node];
+		if (IsPlainTRS(node))
+		{
+			const FbxAMatrix local(node->LclTranslation.Get(), node->LclRotation.Get(), node->LclScaling.Get());
+			MultiplyGlobal(parentGlobal, local, global);
+		}
+		else
+		{
+			// pivots, pre/post rotations etc. are left to the SDK
+			global = node->EvaluateGlobalTransform();
+		}
+
+		for (int i = 0; i < node->GetChildCount(); ++i)
+		{
+			BuildRecursive(node->GetChild(i), global);
+		}
+	}
+
+	void TransformCache::Invalidate()
+	{
+		bValid = false;
+	}
+
+	bool TransformCache::IsValid() const
+	{
+		return bValid;
+	}
+
+	const FbxAMatrix& TransformCache::GetGlobal(FbxNode* node)
+	{
+		auto it = Globals.find(node);
+		if (it != Globals.end())
+		{
+			return it->second;
+		}
+		return Globals[node] = node->EvaluateGlobalTransform();
+	}
+}
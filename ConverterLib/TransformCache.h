@@ -0,0 +1,24 @@
+#pragma once
+
+namespace ConverterLib
+{
+	// Global transforms of all nodes of a Scene, computed in one top-down pass
+	// instead of walking up the parent chain for every single node.
+	// Invalidate whenever a local transform or a parentship changes.
+	class TransformCache
+	{
+	public:
+		void Build(FbxNode* root);
+		void Invalidate();
+		bool IsValid() const;
+
+		// Nodes not below the root given to Build are evaluated by the SDK
+		const FbxAMatrix& GetGlobal(FbxNode* node);
+
+	private:
+		std::unordered_map<FbxNode*, FbxAMatrix> Globals;
+		bool bValid = false;
+
+		void BuildRecursive(FbxNode* node, const FbxAMatrix& parentGlobal);
+	};
+}
@@ -3,15 +3,26 @@
 #pragma once
 #include <iostream>
 #include <string>
+#include <array>
+#include <tuple>
+#include <utility>
 #include <vector>
 #include <queue>
 #include <fstream>
 #include <type_traits>
 #include <cmath>
+#include <limits>
 #include <algorithm>
 #include <functional>
 #include <map>
+#include <set>
+#include <unordered_map>
 #include <filesystem>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 namespace ConverterLib
 {
@@ -54,10 +54,80 @@ namespace MSH2FBX
         [return: MarshalAs(UnmanagedType.LPStr)]
         public static extern string Converter_Get_BaseposeMSH(IntPtr converter);
 
+        [DllImport("MSH2FBX")]
+        public static extern void Converter_Set_ReduceKeyframes(IntPtr converter, bool reduceKeyframes);
+
+        [DllImport("MSH2FBX")]
+        public static extern bool Converter_Get_ReduceKeyframes(IntPtr converter);
+
+        [DllImport("MSH2FBX")]
+        public static extern void Converter_Set_PositionTolerance(IntPtr converter, float tolerance);
+
+        [DllImport("MSH2FBX")]
+        public static extern float Converter_Get_PositionTolerance(IntPtr converter);
+
+        [DllImport("MSH2FBX")]
+        public static extern void Converter_Set_RotationTolerance(IntPtr converter, float tolerance);
+
+        [DllImport("MSH2FBX")]
+        public static extern float Converter_Get_RotationTolerance(IntPtr converter);
+
+        [DllImport("MSH2FBX")]
+        public static extern void Converter_Set_ShareCurves(IntPtr converter, bool shareCurves);
+
+        [DllImport("MSH2FBX")]
+        public static extern bool Converter_Get_ShareCurves(IntPtr converter);
+
+        [DllImport("MSH2FBX")]
+        public static extern void Converter_Set_MinBoneCoverage(IntPtr converter, float minBoneCoverage);
+
+        [DllImport("MSH2FBX")]
+        public static extern float Converter_Get_MinBoneCoverage(IntPtr converter);
+
+        [DllImport("MSH2FBX")]
+        public static extern uint Converter_Get_SkippedAnimationCount(IntPtr converter);
+
+        // the string stays owned by the Converter, so it must not be marshaled (and freed) as LPStr
+        [DllImport("MSH2FBX")]
+        public static extern IntPtr Converter_Get_SkippedAnimation(IntPtr converter, uint index);
+
+        [DllImport("MSH2FBX")]
+        public static extern void Converter_Set_ResampleFrameRate(IntPtr converter, float resampleFrameRate);
+
+        [DllImport("MSH2FBX")]
+        public static extern float Converter_Get_ResampleFrameRate(IntPtr converter);
+
+        [DllImport("MSH2FBX")]
+        public static extern void Converter_Set_NumThreads(IntPtr converter, uint numThreads);
+
+        [DllImport("MSH2FBX")]
+        public static extern uint Converter_Get_NumThreads(IntPtr converter);
+
+        [DllImport("MSH2FBX")]
+        public static extern void Converter_Set_LowMemory(IntPtr converter, bool lowMemory);
+
+        [DllImport("MSH2FBX")]
+        public static extern bool Converter_Get_LowMemory(IntPtr converter);
+
+        [DllImport("MSH2FBX")]
+        public static extern void Converter_Set_LazyParsing(IntPtr converter, bool lazyParsing);
+
+        [DllImport("MSH2FBX")]
+        public static extern bool Converter_Get_LazyParsing(IntPtr converter);
+
+        [DllImport("MSH2FBX")]
+        public static extern void Converter_Set_TagSources(IntPtr converter, bool tagSources);
+
+        [DllImport("MSH2FBX")]
+        public static extern bool Converter_Get_TagSources(IntPtr converter);
+
         // METHODS //
         [DllImport("MSH2FBX")]
         public static extern void Converter_SetLogCallback(LogCallback callback);
 
+        [DllImport("MSH2FBX")]
+        public static extern void Converter_InstallFbxMemoryPool();
+
         [DllImport("MSH2FBX")]
         public static extern bool Converter_Start(IntPtr converter, [MarshalAs(UnmanagedType.LPStr)] string fbxFileName);
 
@@ -70,6 +140,27 @@ namespace MSH2FBX
         [DllImport("MSH2FBX")]
         public static extern bool Converter_SaveFBX(IntPtr converter);
 
+        [DllImport("MSH2FBX")]
+        public static extern bool Converter_SaveFBXAs(IntPtr converter, [MarshalAs(UnmanagedType.LPStr)] string fbxFileName);
+
+        [DllImport("MSH2FBX")]
+        public static extern void Converter_ClearAnimations(IntPtr converter);
+
+        [DllImport("MSH2FBX")]
+        public static extern bool Converter_LoadFBX(IntPtr converter, [MarshalAs(UnmanagedType.LPStr)] string fbxFileName);
+
+        [DllImport("MSH2FBX")]
+        public static extern bool Converter_UpdateMSH(IntPtr converter, [MarshalAs(UnmanagedType.LPStr)] string mshFileName);
+
+        [DllImport("MSH2FBX")]
+        public static extern void Converter_RemoveAnimations(IntPtr converter, [MarshalAs(UnmanagedType.LPStr)] string mshFileName);
+
+        [DllImport("MSH2FBX")]
+        public static extern void Converter_RemoveAnimationsExcept(IntPtr converter, [MarshalAs(UnmanagedType.LPArray, ArraySubType = UnmanagedType.LPStr)] string[] mshFileNames, uint count);
+
+        [DllImport("MSH2FBX")]
+        public static extern void Converter_RemoveMissingSources(IntPtr converter);
+
         [DllImport("MSH2FBX")]
         public static extern bool Converter_ClearFBXScene(IntPtr converter);
 
@@ -1,6 +1,7 @@
 ﻿using System;
 using System.Collections.Generic;
 using System.Linq;
+using System.Runtime.InteropServices;
 using System.Text;
 using System.Threading.Tasks;
 
@@ -93,12 +94,92 @@ namespace MSH2FBX
             set { APIWrapper.Converter_Set_BaseposeMSH(Instance, value); }
         }
 
+        public bool ReduceKeyframes
+        {
+            get { return APIWrapper.Converter_Get_ReduceKeyframes(Instance); }
+            set { APIWrapper.Converter_Set_ReduceKeyframes(Instance, value); }
+        }
+
+        public float PositionTolerance
+        {
+            get { return APIWrapper.Converter_Get_PositionTolerance(Instance); }
+            set { APIWrapper.Converter_Set_PositionTolerance(Instance, value); }
+        }
+
+        public float RotationTolerance
+        {
+            get { return APIWrapper.Converter_Get_RotationTolerance(Instance); }
+            set { APIWrapper.Converter_Set_RotationTolerance(Instance, value); }
+        }
+
+        public bool ShareCurves
+        {
+            get { return APIWrapper.Converter_Get_ShareCurves(Instance); }
+            set { APIWrapper.Converter_Set_ShareCurves(Instance, value); }
+        }
+
+        public float MinBoneCoverage
+        {
+            get { return APIWrapper.Converter_Get_MinBoneCoverage(Instance); }
+            set { APIWrapper.Converter_Set_MinBoneCoverage(Instance, value); }
+        }
+
+        // Animations skipped due to MinBoneCoverage, with their coverage
+        public string[] SkippedAnimations
+        {
+            get
+            {
+                string[] skipped = new string[APIWrapper.Converter_Get_SkippedAnimationCount(Instance)];
+                for (uint i = 0; i < skipped.Length; ++i)
+                {
+                    skipped[i] = Marshal.PtrToStringAnsi(APIWrapper.Converter_Get_SkippedAnimation(Instance, i));
+                }
+                return skipped;
+            }
+        }
+
+        public float ResampleFrameRate
+        {
+            get { return APIWrapper.Converter_Get_ResampleFrameRate(Instance); }
+            set { APIWrapper.Converter_Set_ResampleFrameRate(Instance, value); }
+        }
+
+        public uint NumThreads
+        {
+            get { return APIWrapper.Converter_Get_NumThreads(Instance); }
+            set { APIWrapper.Converter_Set_NumThreads(Instance, value); }
+        }
+
+        public bool LowMemory
+        {
+            get { return APIWrapper.Converter_Get_LowMemory(Instance); }
+            set { APIWrapper.Converter_Set_LowMemory(Instance, value); }
+        }
+
+        public bool LazyParsing
+        {
+            get { return APIWrapper.Converter_Get_LazyParsing(Instance); }
+            set { APIWrapper.Converter_Set_LazyParsing(Instance, value); }
+        }
+
+        public bool TagSources
+        {
+            get { return APIWrapper.Converter_Get_TagSources(Instance); }
+            set { APIWrapper.Converter_Set_TagSources(Instance, value); }
+        }
+
 
         static Converter()
         {
             APIWrapper.Converter_SetLogCallback(callback);
         }
 
+        // Pools small FBX SDK allocations, process wide. Call before the first Converter gets started
+        public static void InstallFbxMemoryPool()
+        {
+            APIWrapper.Converter_InstallFbxMemoryPool();
+        }
+
         public Converter()
         {
             Instance = APIWrapper.Converter_Create();
@@ -135,6 +216,41 @@ namespace MSH2FBX
             return APIWrapper.Converter_SaveFBX(Instance);
         }
 
+        public bool SaveFBX(string fbxFileName)
+        {
+            return APIWrapper.Converter_SaveFBXAs(Instance, fbxFileName);
+        }
+
+        public void ClearAnimations()
+        {
+            APIWrapper.Converter_ClearAnimations(Instance);
+        }
+
+        public bool LoadFBX(string fbxFileName)
+        {
+            return APIWrapper.Converter_LoadFBX(Instance, fbxFileName);
+        }
+
+        public bool UpdateMSH(string mshFileName)
+        {
+            return APIWrapper.Converter_UpdateMSH(Instance, mshFileName);
+        }
+
+        public void RemoveAnimations(string mshFileName)
+        {
+            APIWrapper.Converter_RemoveAnimations(Instance, mshFileName);
+        }
+
+        public void RemoveAnimationsExcept(string[] mshFileNames)
+        {
+            APIWrapper.Converter_RemoveAnimationsExcept(Instance, mshFileNames, (uint)mshFileNames.Length);
+        }
+
+        public void RemoveMissingSources()
+        {
+            APIWrapper.Converter_RemoveMissingSources(Instance);
+        }
+
         public bool ClearFBXScene()
         {
             return APIWrapper.Converter_ClearFBXScene(Instance);
@@ -162,6 +162,252 @@ namespace MSH2FBX
 		}
 		return true;
 	}
+
+	bool ProcessSplitMSH(fs::path mshPath, const fs::path& destination, const bool overrideAnimName, Converter& converter)
+	{
+		fs::path fbxPath = destination.empty() ? mshPath : destination / mshPath.filename();
+		fbxPath.replace_extension(".fbx");
+
+		if (overrideAnimName)
+		{
+			converter.OverrideAnimName = mshPath.filename().replace_extension("").u8string();
+		}
+
+		// the Skeleton stays, just this files Animations will be exported along with it.
+		// Nothing is written for Animations skipped due to their bone coverage
+		const size_t numSkipped = converter.SkippedAnimations.size();
+		bool success = converter.AddMSH(mshPath) && converter.SkippedAnimations.size() == numSkipped && converter.SaveFBX(fbxPath);
+
+		converter.OverrideAnimName = "";
+		converter.ClearAnimations();
+		return success;
+	}
+
+	bool ProcessUpdateMSH(fs::path mshPath, const bool overrideAnimName, Converter& converter)
+	{
+		if (overrideAnimName)
+		{
+			converter.OverrideAnimName = mshPath.filename().replace_extension("").u8string();
+		}
+
+		// only replaces the Animations of this file if its content changed
+		bool success = converter.UpdateMSH(mshPath);
+
+		converter.OverrideAnimName = "";
+		return success;
+	}
+
+	void PrintSkippedAnimations(const Converter& converter)
+	{
+		if (converter.SkippedAnimations.size() == 0)
+		{
+			return;
+		}
+
+		Log("Skipped " + std::to_string(converter.SkippedAnimations.size()) + " Animation(s) not matching the Skeleton:");
+		for (auto it = converter.SkippedAnimations.begin(); it != converter.SkippedAnimations.end(); ++it)
+		{
+			Log("\t" + *it);
+		}
+	}
+
+	// Length of the valid UTF-8 sequence starting at 'pos', 0 if there is none
+	size_t UTF8SequenceLength(const string& text, const size_t pos)
+	{
+		const unsigned char lead = (unsigned char)text[pos];
+		size_t length;
+		uint32_t codepoint;
+		if (lead >= 0xC2 && lead <= 0xDF)
+		{
+			length = 2;
+			codepoint = lead & 0x1F;
+		}
+		else if (lead >= 0xE0 && lead <= 0xEF)
+		{
+			length = 3;
+			codepoint = lead & 0x0F;
+		}
+		else if (lead >= 0xF0 && lead <= 0xF4)
+		{
+			length = 4;
+			codepoint = lead & 0x07;
+		}
+		else
+		{
+			return 0;
+		}
+
+		if (pos + length > text.size())
+		{
+			return 0;
+		}
+		for (size_t i = 1; i < length; ++i)
+		{
+			const unsigned char next = (unsigned char)text[pos + i];
+			if ((next & 0xC0) != 0x80)
+			{
+				return 0;
+			}
+			codepoint = (codepoint << 6) | (next & 0x3F);
+		}
+
+		// overlong encodings, surrogates and anything past U+10FFFF
+		if ((length == 3 && codepoint < 0x800) || (length == 4 && codepoint < 0x10000) ||
+			(codepoint >= 0xD800 && codepoint <= 0xDFFF) || codepoint > 0x10FFFF)
+		{
+			return 0;
+		}
+		return length;
+	}
+
+	// Quoted and escaped JSON string. MSH names are in some 8-bit codepage, bytes
+	// that don't form valid UTF-8 are taken as Latin-1 and written as \u00XX
+	string JsonString(const string& text)
+	{
+		string json = "\"";
+		for (size_t i = 0; i < text.size(); ++i)
+		{
+			const char c = text[i];
+			switch (c)
+			{
+				case '"': json += "\\\""; break;
+				case '\\': json += "\\\\"; break;
+				case '\n': json += "\\n"; break;
+				case '\r': json += "\\r"; break;
+				case '\t': json += "\\t"; break;
+				default:
+					if ((unsigned char)c < 0x20)
+					{
+						char escaped[8];
+						snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+						json += escaped;
+					}
+					else if ((unsigned char)c >= 0x80)
+					{
+						const size_t length = UTF8SequenceLength(text, i);
+						if (length > 0)
+						{
+							json.append(text, i, length);
+							i += length - 1;
+						}
+						else
+						{
+							char escaped[8];
+							snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned char)c);
+							json += escaped;
+						}
+					}
+					else
+					{
+						json += c;
+					}
+			}
+		}
+		return json + "\"";
+	}
+
+	// JSON object summarizing the given MSH, see --inspect
+	string InspectMSH(const fs::path& mshFilePath)
+	{
+		string json = "{\"file\":" + JsonString(mshFilePath.u8string());
+
+		MSHScanner scanner;
+		MSHSummary summary;
+		if (!scanner.Open(mshFilePath) || !scanner.ReadSummary(summary))
+		{
+			return json + ",\"error\":\"Could not read the chunks of this file\"}";
+		}
+
+		json += ",\"materials\":[";
+		for (size_t i = 0; i < summary.Materials.size(); ++i)
+		{
+			const MSHSummary::Material& material = summary.Materials[i];
+			json += (i > 0 ? ",{" : "{") + string("\"name\":") + JsonString(material.Name) + ",\"textures\":[";
+			for (size_t t = 0; t < material.Textures.size(); ++t)
+			{
+				json += (t > 0 ? "," : "") + JsonString(material.Textures[t]);
+			}
+			json += "]}";
+		}
+
+		json += "],\"models\":[";
+		for (size_t i = 0; i < summary.Models.size(); ++i)
+		{
+			const MSHSummary::Model& model = summary.Models[i];
+			uint32_t numVertices = 0;
+			uint32_t numTriangles = 0;
+			string segments;
+			for (size_t s = 0; s < model.Segments.size(); ++s)
+			{
+				const MSHSummary::Segment& segment = model.Segments[s];
+				numVertices += segment.NumVertices;
+				numTriangles += segment.NumTriangles;
+				segments += (s > 0 ? ",{" : "{") + string("\"material\":") + std::to_string(segment.MaterialIndex) +
+					",\"vertices\":" + std::to_string(segment.NumVertices) + ",\"triangles\":" + std::to_string(segment.NumTriangles) + "}";
+			}
+
+			json += (i > 0 ? ",{" : "{") + string("\"name\":") + JsonString(model.Name) +
+				",\"parent\":" + JsonString(model.Parent) +
+				",\"type\":" + std::to_string(model.ModelType) +
+				",\"purpose\":" + JsonString(ModelPurposeToString(model.Purpose).Buffer()) +
+				",\"vertices\":" + std::to_string(numVertices) +
+				",\"triangles\":" + std::to_string(numTriangles) +
+				",\"segments\":[" + segments + "]}";
+		}
+
+		json += "],\"bones\":[";
+		for (size_t i = 0; i < summary.Bones.size(); ++i)
+		{
+			json += (i > 0 ? ",{" : "{") + string("\"name\":") + JsonString(summary.Bones[i].Name) + ",\"crc\":" + std::to_string(summary.Bones[i].CRC) + "}";
+		}
+
+		json += "],\"animations\":[";
+		for (size_t i = 0; i < summary.Animations.size(); ++i)
+		{
+			const MSHSummary::Animation& animation = summary.Animations[i];
+			json += (i > 0 ? ",{" : "{") + string("\"name\":") + JsonString(animation.Name) +
+				",\"frameRate\":" + (std::isfinite(animation.FrameRate) ? std::to_string(animation.FrameRate) : string("null")) +
+				",\"firstFrame\":" + std::to_string(animation.FirstFrame) +
+				",\"lastFrame\":" + std::to_string(animation.LastFrame) + "}";
+		}
+
+		return json + "],\"animatedBones\":" + std::to_string(summary.NumAnimatedBones) + "}";
+	}
+
+	// Prints a JSON array with one summary per file. Neither
+	// an FbxManager nor an FbxScene is involved
+	void InspectFiles(const vector<fs::path>& mshFilePaths, const uint32_t numThreads)
+	{
+		vector<string> summaries(mshFilePaths.size());
+		ThreadPool pool(numThreads);
+		pool.ParallelFor(mshFilePaths.size(), [&](const size_t begin, const size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				summaries[i] = InspectMSH(mshFilePaths[i]);
+			}
+		});
+
+		std::cout << "[";
+		for (size_t i = 0; i < summaries.size(); ++i)
+		{
+			std::cout << (i > 0 ? ",\n" : "\n") << summaries[i];
+		}
+		std::cout << "\n]" << std::endl;
+	}
+
+	void PrintMemoryStats()
+	{
+		if (!FbxMemoryPool::IsInstalled())
+		{
+			Log("FBX SDK allocations are only counted with --pooled-fbx-alloc");
+			return;
+		}
+
+		const FbxMemoryStats stats = FbxMemoryPool::GetStats();
+		Log("FBX SDK allocations: " + std::to_string(stats.Allocations) + " (" + std::to_string(stats.PooledAllocations) + " pooled), frees: " + std::to_string(stats.Frees));
+		Log("FBX SDK pool: " + std::to_string(stats.Slabs) + " slab(s), " + std::to_string(stats.SlabBytes / 1024) + " KiB held");
+	}
 }
 
 // the main function must not lie inside a namespace
@@ -224,6 +470,11 @@ int main(int argc, char *argv[])
 	vector<string> filter;
 	fs::path fbxDestination = "";
 	fs::path mshBaseposeFile = "";
+	float positionTolerance = 0.0001f;
+	float rotationTolerance = 0.01f;
+	float minBoneCoverage = 0.0f;
+	float resampleFrameRate = 0.0f;
+	uint32_t numThreads = 0;
 
 	// Build up Command Line Parser
 	CLI::App app
@@ -255,8 +506,23 @@ int main(int argc, char *argv[])
 	CLI::Option* recOpt = app.add_flag("-r,--recursive", "For all given directories, crawling will be recursive (will include all sub-directories).");
 	CLI::Option* emptOpt = app.add_flag("-e,--empty-meshes", "Meshes won't be processed and will end up empty. This is usefull to convert Animations.");
 	CLI::Option* printOpt = app.add_flag("-p,--print-hierarchy", "Print the hierarchy of the resulting FBX file(s).");
-
-	string filterOptionInfo = "What to ignore. Options are:\n";
+	CLI::Option* splitOpt = app.add_flag("-s,--split-animations", "Build the Skeleton from the given Models (-m) and Basepose (-b) once, then write one FBX per Animation file (-a), each containing that Skeleton. A destination (-d) must be a directory.");
+	CLI::Option* reduceOpt = app.add_flag("-k,--reduce-keyframes", "Drop Animation keyframes that linear interpolation already reproduces, and collapse constant channels to a single key.");
+	app.add_option("--position-tolerance", positionTolerance, "Maximum position error (in units) for keyframe reduction. Default: 0.0001");
+	app.add_option("--rotation-tolerance", rotationTolerance, "Maximum rotation error (in degrees) for keyframe reduction. Default: 0.01");
+	CLI::Option* shareOpt = app.add_flag("--share-curves", "Reuse identical Animation curves across all Animations merged into one FBX, instead of storing them again.");
+	app.add_option("-c,--min-bone-coverage", minBoneCoverage, "Skip Animations of which less than this fraction (0.0 - 1.0) of bones is found in the loaded Skeleton. Skipped Animations are listed at the end. Default: 0 (convert all)")->check(CLI::Range(0.0f, 1.0f));
+	app.add_option("--resample", resampleFrameRate, "Resample all Animations to keys on a uniform grid of this frame rate (e.g. 30). Default: 0 (keep keys as they are)")->check(CLI::Range(0.0f, 1000.0f));
+	app.add_option("-j,--threads", numThreads, "Number of threads used for conversion. Default: 0 (one per CPU core)");
+	CLI::Option* inspectOpt = app.add_flag("--inspect", "Don't convert anything, just print a JSON summary of all given MSH files (models, materials, bones and animations).");
+	CLI::Option* fullParseOpt = app.add_flag("--full-parse", "Always decode MSH files as a whole. By default, only the chunks needed are decoded: Animation only inputs (-a) skip everything but the Animation chunks, and ignored Models (-i) their geometry.");
+	CLI::Option* lowMemOpt = app.add_flag("--low-memory", "Convert Meshes one at a time, streaming their geometry into the FBX and freeing it right away. Lowers peak memory on large Meshes, at the cost of multi-threading.");
+	CLI::Option* pooledOpt = app.add_flag("--pooled-fbx-alloc", "Serve the many small FBX SDK allocations from a memory pool instead of the SDK's heap. Experimental.");
+	CLI::Option* memStatsOpt = app.add_flag("--memory-stats", "Print FBX SDK allocation counts and pool usage at the end (requires --pooled-fbx-alloc).");
+	CLI::Option* pruneOpt = app.add_flag("--prune", "With -u, also remove the Animations of all MSHs not given this time (-a).");
+	CLI::Option* updateOpt = app.add_flag("-u,--update", "Update an existing merged FBX (-d) in place: only Animations (-a) whose MSH changed are replaced, new ones are added and the ones whose MSH no longer exists are removed. Banks to be updated must have been created with -u as well.");
+
+	string filterOptionInfo = "What to ignore (the geometry of ignored Models isn't decoded, unless --full-parse is given). Options are:\n";
 	for (auto it = filterMap.begin(); it != filterMap.end(); ++it)
 	{
 		filterOptionInfo += "\t\t\t\t" + it->first + "\n";
@@ -266,9 +532,52 @@ int main(int argc, char *argv[])
 	// *parse magic*
 	CLI11_PARSE(app, argc, argv);
 
+	// Inspecting needs neither a destination nor a Basepose, so none of the checks below apply
+	if (inspectOpt->count() > 0)
+	{
+		vector<fs::path> allFiles = GetFiles(files, ".msh", recOpt->count() > 0);
+		const vector<fs::path> modelFiles = GetFiles(models, ".msh", recOpt->count() > 0);
+		const vector<fs::path> animationFiles = GetFiles(animations, ".msh", recOpt->count() > 0);
+		allFiles.insert(allFiles.end(), modelFiles.begin(), modelFiles.end());
+		allFiles.insert(allFiles.end(), animationFiles.begin(), animationFiles.end());
+		InspectFiles(allFiles, numThreads);
+		return 0;
+	}
+
+	// the range check lets NaN through
+	if (!std::isfinite(resampleFrameRate))
+	{
+		Log("Resampling requires a finite frame rate (--resample)!");
+		Log(app.help());
+		return 0;
+	}
+
+	const bool splitAnimations = splitOpt->count() > 0;
+	const bool updateBank = updateOpt->count() > 0;
 	bool singleFbxFile = false;
 	fs::path filename = fbxDestination.filename();
-	if (!fbxDestination.empty())
+	if (updateBank && (splitAnimations || fbxDestination.extension() != ".fbx"))
+	{
+		Log("Updating requires a single FBX File Name as destination (-d) and cannot be combined with splitting (-s)!");
+		Log(app.help());
+		return 0;
+	}
+	else if (splitAnimations)
+	{
+		if (models.size() == 0 || animations.size() == 0 || files.size() > 0)
+		{
+			Log("Splitting Animations requires Models (-m) and Animations (-a) only!");
+			Log(app.help());
+			return 0;
+		}
+		else if (!fbxDestination.empty() && !fs::is_directory(fbxDestination))
+		{
+			Log("Given destination directory does not exist!");
+			Log(app.help());
+			return 0;
+		}
+	}
+	else if (!fbxDestination.empty())
 	{
 		if (IsDirectory(fbxDestination) && !fs::exists(fbxDestination))
 		{
@@ -288,7 +597,7 @@ int main(int argc, char *argv[])
 		}
 	}
 
-	if (!singleFbxFile && mshBaseposeFile != "")
+	if (!singleFbxFile && !splitAnimations && mshBaseposeFile != "")
 	{
 		Log("Cannot apply Basepose in multi export mode! You need to specify a single FBX to merge everything to!");
 		Log(app.help());
@@ -313,12 +622,28 @@ int main(int argc, char *argv[])
 	size_t fileCounter = 0;
 	size_t successCounter = 0;
 
+	// must be in place before the first Converter starts
+	if (pooledOpt->count() > 0)
+	{
+		FbxMemoryPool::Install();
+	}
+
 	Converter converter;
 	converter.SetLogCallback(&ReceiveLogFromConverter);
 	converter.bEmptyMeshes = emptOpt->count() > 0;
 	converter.bPrintHierachy = printOpt->count() > 0;
+	converter.bReduceKeyframes = reduceOpt->count() > 0;
+	converter.PositionTolerance = positionTolerance;
+	converter.RotationTolerance = rotationTolerance;
+	converter.bShareCurves = shareOpt->count() > 0;
+	converter.bLowMemory = lowMemOpt->count() > 0;
+	converter.bLazyParsing = fullParseOpt->count() == 0;
+	converter.bTagSources = updateBank;	// hashes every MSH, only worth it for banks that are updated later on
+	converter.MinBoneCoverage = minBoneCoverage;
+	converter.ResampleFrameRate = resampleFrameRate;
+	converter.NumThreads = numThreads;
 	converter.BaseposeMSH = mshBaseposeFile;
-	converter.Start(fbxDestination);
+	converter.Start(splitAnimations ? "" : fbxDestination);
 
 	// allow everything by default
 	converter.ModelIgnoreFilter = (EModelPurpose)0;
@@ -336,6 +661,61 @@ int main(int argc, char *argv[])
 		}
 	}
 
+	// Build the Skeleton (and Bindpose) once from all Models, then
+	// reuse it for every Animation, exporting one FBX per Animation
+	if (splitAnimations)
+	{
+		converter.ChunkFilter = EChunkFilter::Animations;
+		for (auto it = models.begin(); it != models.end(); ++it)
+		{
+			ShowProgress((*it).filename().u8string(), (float)(fileCounter++) / numFiles);
+			if (converter.AddMSH(*it))
+			{
+				++successCounter;
+			}
+		}
+
+		converter.ChunkFilter = EChunkFilter::Models;
+		for (auto it = animations.begin(); it != animations.end(); ++it)
+		{
+			ShowProgress((*it).filename().u8string(), (float)(fileCounter++) / numFiles);
+			if (ProcessSplitMSH(*it, fbxDestination, overrideAnimName, converter))
+			{
+				++successCounter;
+			}
+		}
+
+		converter.Close();
+		FinishProgress(successCounter > 0 ? "Done!" : "No files processed...");
+		PrintSkippedAnimations(converter);
+		if (memStatsOpt->count() > 0)
+		{
+			PrintMemoryStats();
+		}
+		return 0;
+	}
+
+	// Open the existing bank, whose Skeleton and Models are kept as they are.
+	// Only Animations whose source MSH changed will be reconverted
+	const bool updateExisting = updateBank && fs::exists(fbxDestination);
+	if (updateExisting)
+	{
+		if (!converter.LoadFBX(fbxDestination))
+		{
+			converter.Close();
+			FinishProgress("No files processed...");
+			return 0;
+		}
+
+		if (models.size() > 0 || files.size() > 0)
+		{
+			Log("Updating an existing FBX, ignoring Models (-m) and Files (-f)!");
+			fileCounter += models.size() + files.size();
+			models.clear();
+			files.clear();
+		}
+	}
+
 	// Import Models first (specified with -m), ignoring Animations
 	converter.ChunkFilter = EChunkFilter::Animations;
 	for (auto it = models.begin(); it != models.end(); ++it)
@@ -363,12 +743,24 @@ int main(int argc, char *argv[])
 	for (auto it = animations.begin(); it != animations.end(); ++it)
 	{
 		ShowProgress((*it).filename().u8string(), (float)(fileCounter++) / numFiles);
-		if (ProcessMSH(*it, overrideAnimName, converter, !singleFbxFile))
+		if (updateExisting ? ProcessUpdateMSH(*it, overrideAnimName, converter) : ProcessMSH(*it, overrideAnimName, converter, !singleFbxFile))
 		{
 			++successCounter;
 		}
 	}
 
+	if (updateExisting)
+	{
+		if (pruneOpt->count() > 0)
+		{
+			converter.RemoveAnimationsExcept(animations);
+		}
+		else
+		{
+			converter.RemoveMissingSources();
+		}
+	}
+
 	if (singleFbxFile)
 	{
 		if (successCounter == 0)
@@ -384,6 +776,11 @@ int main(int argc, char *argv[])
 	}
 
 	FinishProgress(successCounter > 0 ? "Done!" : "No files processed...");
+	PrintSkippedAnimations(converter);
+	if (memStatsOpt->count() > 0)
+	{
+		PrintMemoryStats();
+	}
 
 #if _DEBUG
 	std::cin.get();
@@ -6,6 +6,11 @@ namespace MSH2FBX
 	using ConverterLib::Converter;
 	using ConverterLib::EChunkFilter;
 	using ConverterLib::LogCallback;
+	using ConverterLib::FbxMemoryPool;
+	using ConverterLib::FbxMemoryStats;
+	using ConverterLib::MSHScanner;
+	using ConverterLib::MSHSummary;
+	using ConverterLib::ThreadPool;
 	using LibSWBF2::EModelPurpose;
 	namespace fs = std::filesystem;
 
@@ -22,4 +27,7 @@ namespace MSH2FBX
 	vector<fs::path> GetFiles(const vector<fs::path>& Paths, const string& Extension, const bool recursive);
 
 	bool ProcessMSH(fs::path filename, const bool overrideAnimName, Converter& converter, const bool createFBXFile);
+	bool ProcessSplitMSH(fs::path filename, const fs::path& destination, const bool overrideAnimName, Converter& converter);
+	bool ProcessUpdateMSH(fs::path filename, const bool overrideAnimName, Converter& converter);
+	void PrintSkippedAnimations(const Converter& converter);
 }
\ No newline at end of file
@@ -73,11 +73,142 @@ namespace MSH2FBX
 		return converter->BaseposeMSH.u8string().c_str();
 	}
 
+
+	MSH2FBX_API void Converter_Set_ReduceKeyframes(Converter* converter, const bool reduceKeyframes)
+	{
+		converter->bReduceKeyframes = reduceKeyframes;
+	}
+
+	MSH2FBX_API bool Converter_Get_ReduceKeyframes(const Converter* converter)
+	{
+		return converter->bReduceKeyframes;
+	}
+
+
+	MSH2FBX_API void Converter_Set_PositionTolerance(Converter* converter, const float tolerance)
+	{
+		converter->PositionTolerance = tolerance;
+	}
+
+	MSH2FBX_API float Converter_Get_PositionTolerance(const Converter* converter)
+	{
+		return converter->PositionTolerance;
+	}
+
+
+	MSH2FBX_API void Converter_Set_RotationTolerance(Converter* converter, const float tolerance)
+	{
+		converter->RotationTolerance = tolerance;
+	}
+
+	MSH2FBX_API float Converter_Get_RotationTolerance(const Converter* converter)
+	{
+		return converter->RotationTolerance;
+	}
+
+
+	MSH2FBX_API void Converter_Set_ShareCurves(Converter* converter, const bool shareCurves)
+	{
+		converter->bShareCurves = shareCurves;
+	}
+
+	MSH2FBX_API bool Converter_Get_ShareCurves(const Converter* converter)
+	{
+		return converter->bShareCurves;
+	}
+
+
+	MSH2FBX_API void Converter_Set_MinBoneCoverage(Converter* converter, const float minBoneCoverage)
+	{
+		converter->MinBoneCoverage = minBoneCoverage;
+	}
+
+	MSH2FBX_API float Converter_Get_MinBoneCoverage(const Converter* converter)
+	{
+		return converter->MinBoneCoverage;
+	}
+
+	MSH2FBX_API uint32_t Converter_Get_SkippedAnimationCount(const Converter* converter)
+	{
+		return (uint32_t)converter->SkippedAnimations.size();
+	}
+
+	// owned by the Converter, valid until the next conversion
+	MSH2FBX_API const char* Converter_Get_SkippedAnimation(const Converter* converter, const uint32_t index)
+	{
+		if (index >= converter->SkippedAnimations.size())
+		{
+			return nullptr;
+		}
+		return converter->SkippedAnimations[index].c_str();
+	}
+
+
+	MSH2FBX_API void Converter_Set_ResampleFrameRate(Converter* converter, const float resampleFrameRate)
+	{
+		converter->ResampleFrameRate = resampleFrameRate;
+	}
+
+	MSH2FBX_API float Converter_Get_ResampleFrameRate(const Converter* converter)
+	{
+		return converter->ResampleFrameRate;
+	}
+
+
+	MSH2FBX_API void Converter_Set_NumThreads(Converter* converter, const uint32_t numThreads)
+	{
+		converter->NumThreads = numThreads;
+	}
+
+	MSH2FBX_API uint32_t Converter_Get_NumThreads(const Converter* converter)
+	{
+		return converter->NumThreads;
+	}
+
+
+	MSH2FBX_API void Converter_Set_LowMemory(Converter* converter, const bool lowMemory)
+	{
+		converter->bLowMemory = lowMemory;
+	}
+
+	MSH2FBX_API bool Converter_Get_LowMemory(const Converter* converter)
+	{
+		return converter->bLowMemory;
+	}
+
+
+	MSH2FBX_API void Converter_Set_LazyParsing(Converter* converter, const bool lazyParsing)
+	{
+		converter->bLazyParsing = lazyParsing;
+	}
+
+	MSH2FBX_API bool Converter_Get_LazyParsing(const Converter* converter)
+	{
+		return converter->bLazyParsing;
+	}
+
+
+	MSH2FBX_API void Converter_Set_TagSources(Converter* converter, const bool tagSources)
+	{
+		converter->bTagSources = tagSources;
+	}
+
+	MSH2FBX_API bool Converter_Get_TagSources(const Converter* converter)
+	{
+		return converter->bTagSources;
+	}
+
 	MSH2FBX_API void Converter_SetLogCallback(const LogCallback Callback)
 	{
 		Converter::SetLogCallback(Callback);
 	}
 
+	// process wide, call before the first Converter gets started
+	MSH2FBX_API void Converter_InstallFbxMemoryPool()
+	{
+		ConverterLib::FbxMemoryPool::Install();
+	}
+
 	MSH2FBX_API bool Converter_Start(Converter* converter, const char* fbxFileName)
 	{
 		return converter->Start(fs::path(fbxFileName));
@@ -98,6 +229,46 @@ namespace MSH2FBX
 		return converter->SaveFBX();
 	}
 
+	MSH2FBX_API bool Converter_SaveFBXAs(Converter* converter, const char* fbxFileName)
+	{
+		return converter->SaveFBX(fs::path(fbxFileName));
+	}
+
+	MSH2FBX_API void Converter_ClearAnimations(Converter* converter)
+	{
+		converter->ClearAnimations();
+	}
+
+	MSH2FBX_API bool Converter_LoadFBX(Converter* converter, const char* fbxFileName)
+	{
+		return converter->LoadFBX(fs::path(fbxFileName));
+	}
+
+	MSH2FBX_API bool Converter_UpdateMSH(Converter* converter, const char* mshFileName)
+	{
+		return converter->UpdateMSH(fs::path(mshFileName));
+	}
+
+	MSH2FBX_API void Converter_RemoveAnimations(Converter* converter, const char* mshFileName)
+	{
+		converter->RemoveAnimations(fs::path(mshFileName));
+	}
+
+	MSH2FBX_API void Converter_RemoveAnimationsExcept(Converter* converter, const char** mshFileNames, const uint32_t count)
+	{
+		vector<fs::path> mshFilePaths;
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			mshFilePaths.emplace_back(mshFileNames[i]);
+		}
+		converter->RemoveAnimationsExcept(mshFilePaths);
+	}
+
+	MSH2FBX_API void Converter_RemoveMissingSources(Converter* converter)
+	{
+		converter->RemoveMissingSources();
+	}
+
 	MSH2FBX_API bool Converter_ClearFBXScene(Converter* converter)
 	{
 		return converter->ClearFBXScene();
@@ -48,12 +48,52 @@ namespace MSH2FBX
 		MSH2FBX_API void Converter_Set_BaseposeMSH(Converter* converter, const char* baseposeMSH);
 		MSH2FBX_API const char* Converter_Get_BaseposeMSH(const Converter* converter);
 
+		MSH2FBX_API void Converter_Set_ReduceKeyframes(Converter* converter, const bool reduceKeyframes);
+		MSH2FBX_API bool Converter_Get_ReduceKeyframes(const Converter* converter);
+
+		MSH2FBX_API void Converter_Set_PositionTolerance(Converter* converter, const float tolerance);
+		MSH2FBX_API float Converter_Get_PositionTolerance(const Converter* converter);
+
+		MSH2FBX_API void Converter_Set_RotationTolerance(Converter* converter, const float tolerance);
+		MSH2FBX_API float Converter_Get_RotationTolerance(const Converter* converter);
+
+		MSH2FBX_API void Converter_Set_ShareCurves(Converter* converter, const bool shareCurves);
+		MSH2FBX_API bool Converter_Get_ShareCurves(const Converter* converter);
+
+		MSH2FBX_API void Converter_Set_MinBoneCoverage(Converter* converter, const float minBoneCoverage);
+		MSH2FBX_API float Converter_Get_MinBoneCoverage(const Converter* converter);
+		MSH2FBX_API uint32_t Converter_Get_SkippedAnimationCount(const Converter* converter);
+		MSH2FBX_API const char* Converter_Get_SkippedAnimation(const Converter* converter, const uint32_t index);
+
+		MSH2FBX_API void Converter_Set_ResampleFrameRate(Converter* converter, const float resampleFrameRate);
+		MSH2FBX_API float Converter_Get_ResampleFrameRate(const Converter* converter);
+
+		MSH2FBX_API void Converter_Set_NumThreads(Converter* converter, const uint32_t numThreads);
+		MSH2FBX_API uint32_t Converter_Get_NumThreads(const Converter* converter);
+
+		MSH2FBX_API void Converter_Set_LowMemory(Converter* converter, const bool lowMemory);
+		MSH2FBX_API bool Converter_Get_LowMemory(const Converter* converter);
+
+		MSH2FBX_API void Converter_Set_LazyParsing(Converter* converter, const bool lazyParsing);
+		MSH2FBX_API bool Converter_Get_LazyParsing(const Converter* converter);
+
+		MSH2FBX_API void Converter_Set_TagSources(Converter* converter, const bool tagSources);
+		MSH2FBX_API bool Converter_Get_TagSources(const Converter* converter);
+
 		// METHODS //
 		MSH2FBX_API void Converter_SetLogCallback(const LogCallback Callback);
+		MSH2FBX_API void Converter_InstallFbxMemoryPool();
 		MSH2FBX_API bool Converter_Start(Converter* converter, const char* fbxFileName);
 		MSH2FBX_API bool Converter_AddMSHFromPath(Converter* converter, const char* mshFileName);
 		MSH2FBX_API bool Converter_AddMSHFromPtr(Converter* converter, MSH* msh);
 		MSH2FBX_API bool Converter_SaveFBX(Converter* converter);
+		MSH2FBX_API bool Converter_SaveFBXAs(Converter* converter, const char* fbxFileName);
+		MSH2FBX_API void Converter_ClearAnimations(Converter* converter);
+		MSH2FBX_API bool Converter_LoadFBX(Converter* converter, const char* fbxFileName);
+		MSH2FBX_API bool Converter_UpdateMSH(Converter* converter, const char* mshFileName);
+		MSH2FBX_API void Converter_RemoveAnimations(Converter* converter, const char* mshFileName);
+		MSH2FBX_API void Converter_RemoveAnimationsExcept(Converter* converter, const char** mshFileNames, const uint32_t count);
+		MSH2FBX_API void Converter_RemoveMissingSources(Converter* converter);
 		MSH2FBX_API bool Converter_ClearFBXScene(Converter* converter);
 		MSH2FBX_API void Converter_Close(Converter* converter);
 	}